@@ -7,20 +7,22 @@ void configure(syApp *app) {
 }
 
 void loop(syApp *app) {
-  syClear(SY_WHITE);
+  syClear(app, SY_WHITE);
 
   sySetColor(app, SY_BLACK);
 
+  syPushMatrix(app);
   syTranslate(app, app->width * 0.25, app->height * 0.75, 0);
   syRotate(app, app->time * 0.05, 0, 0, 1);
   syDrawQuad(app, -100, -100, 200, 200);
-  syResetTransformations(app);
+  syPopMatrix(app);
 
   sySetColor(app, SY_MAGENTA);
+  syPushMatrix(app);
   syTranslate(app, app->width * 0.75, app->height * 0.75, 0);
   syRotate(app, app->time * -0.15, 0, 0, 1);
   syDrawPolygon(app, 0, 0, 0, 200, 7);
-  syResetTransformations(app);
+  syPopMatrix(app);
 
   sySetColor(app, SY_GREEN);
   float linePts[] = {250, 250, 0,   250, 500, 0,   500, 500,
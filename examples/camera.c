@@ -16,7 +16,7 @@ void setup(syApp *app) {
 
 void loop(syApp *app) {
   syCameraUpdate(app, &cam);
-  syClear(SY_BLACK);
+  syClear(app, SY_BLACK);
   sySetColor(app, SY_MAGENTA);
   syDrawCube(app, &(syCube){.size = 1, .center = (vec3s){{0, 0.5, 0}}});
   syDrawSphere(app, &(sySphere){.radius = 1, .center = (vec3s){{4, 1, 0}}});
@@ -0,0 +1,56 @@
+//
+// Example: extras-particles.c
+// Description:
+// A million particles in a perlin noise flow field, updated on all cores.
+//
+
+#include <soya/soya.h>
+#include <soya/extras/particles.h>
+
+#define NUM_PARTICLES 1000000
+
+static syParticles particles;
+static bool ready;
+
+// Steers the particles along a perlin noise flow field. Called from several
+// threads with disjoint ranges.
+static void flowField(syParticles *p, size_t begin, size_t end, float dt,
+                      void *userData) {
+  (void)dt;
+  float t = (float)*(double *)userData * 0.5f;
+  float noisef = 0.005f;
+  for (size_t i = begin; i < end; i++) {
+    vec3 n = {p->x[i] * noisef, p->y[i] * noisef, t};
+    float heading = glm_perlin_vec3(n) * GLM_PI * 2;
+    p->vx[i] = cosf(heading) * p->opts.speed;
+    p->vy[i] = sinf(heading) * p->opts.speed;
+  }
+}
+
+void configure(syApp *app) {
+  app->width = 1200;
+  app->height = 800;
+}
+
+void setup(syApp *app) {
+  syParticlesOptions opts = {
+      .count = NUM_PARTICLES,
+      .spawnMin = {0, 0, 0},
+      .spawnMax = {(float)app->width, (float)app->height, 0},
+      .speed = 90,
+      .minLifetime = 0.5f,
+      .maxLifetime = 3,
+      .force = flowField,
+      .userData = &app->time,
+  };
+  ready = syParticlesInit(&particles, &opts);
+}
+
+void loop(syApp *app) {
+  syClear(app, SY_BLACK);
+  if (!ready) {
+    return;
+  }
+  syParticlesUpdate(&particles, app->fps > 0 ? 1.f / app->fps : 0);
+  syDrawUnindexed(app, particles.positions, NULL, NUM_PARTICLES, GL_POINTS);
+}
@@ -1,7 +1,9 @@
 //
 // Example: extras-pipeencoder.c
 // Description:
-// Use the pipe encoder to record applpication for 5 seconds with ffmpeg.
+// Use the pipe encoder to record applpication for 5 seconds with ffmpeg. The
+// offline clock advances time by exactly 1/120 s per frame, so the video is
+// smooth however long each frame takes to render.
 
 //
 // This header must be included at the very top because it declares POSIX
@@ -9,13 +11,15 @@
 // imported.
 //
 
-#define SOYA_NO_CONFIGURE
-
 #include <soya/extras/pipeencoder.h>
 #include <soya/soya.h>
 
+#define FPS 120
+
 syPipeEncoder encoder;
 
+void configure(syApp *app) { app->offlineFps = FPS; }
+
 void setup(syApp *app) {
   syPipeEncoderOptions opts = {0};  // First initialize `opts` to 0.
   //
@@ -25,7 +29,7 @@ void setup(syApp *app) {
   opts.width = app->width;
   opts.height = app->height;
   opts.codec = "h264_nvenc";
-  opts.inputFps = 120;
+  opts.inputFps = FPS;
   opts.outputFps = 60;
   opts.outputPath = "../../pipeencoder-example.mp4";
   opts.inputPixelFormat = "rgb24";
@@ -34,19 +38,19 @@ void setup(syApp *app) {
 }
 
 void loop(syApp *app) {
-  syClear(SY_RED);
+  syClear(app, SY_RED);
   syTranslate(app, app->width / 2., app->height / 2., 0);
-  float r = (sinf(app->frameNum / 120.0) * 0.5 + 0.5) * 250 + 100;
+  float r = (sinf((float)app->time) * 0.5 + 0.5) * 250 + 100;
   syDrawPolygon(app, 0, 0, 0, r, 72);
   syResetTransformations(app);
 
   if (app->frameNum == 0) {
     syPipeEncoderStart(&encoder);
-  } else if (app->frameNum >= 120 * 5)  // 5 seconds with 120 fps
-  {
+  } else if (app->time >= 5) {
     syPipeEncoderStop(&encoder);
     glfwSetWindowShouldClose(app->window, true);
   } else {
+    syFlush(app);  // Submit batched draws before reading the pixels back
     void *pixels = calloc(app->width * app->height * 3, sizeof(int));
     glReadPixels(0, 0, app->width, app->height, GL_RGB, GL_UNSIGNED_BYTE,
                  pixels);
@@ -0,0 +1,51 @@
+//
+// Example: extras-polyline.c
+// Description:
+// A few thousand wavy polylines drawn as thick ribbons with round joins. The
+// points are uploaded once and only uploaded again when the polylines change,
+// every few seconds.
+//
+
+#define SOYA_NO_CONFIGURE
+#include <soya/soya.h>
+#include <soya/extras/polylinemesh.h>
+
+#define NUM_LINES 2000
+#define NUM_POINTS 100
+
+static syPl lines[NUM_LINES];
+static syPlMesh mesh;
+static int generation = -1;
+
+static void generate(syApp *app, int seed) {
+  for (int i = 0; i < NUM_LINES; i++) {
+    float y = ((float)i / NUM_LINES) * (float)app->height;
+    float phase = (float)((i * 7 + seed * 13) % 31);
+    for (int j = 0; j < NUM_POINTS; j++) {
+      float x = (float)j / (NUM_POINTS - 1) * (float)app->width;
+      lines[i].data[j] = (vec3s){{x, y + sinf(x * 0.02f + phase) * 12.f, 0}};
+    }
+    syPlUpdate(&lines[i]);
+  }
+}
+
+void setup(syApp *app) {
+  for (int i = 0; i < NUM_LINES; i++) {
+    syPlInit(&lines[i]);
+    for (int j = 0; j < NUM_POINTS; j++) {
+      syPlAddVertex(&lines[i], (vec3s){{0, 0, 0}});
+    }
+  }
+  syPlMeshInit(&app->renderer.gl, &mesh, SY_PL_JOIN_ROUND);
+}
+
+void loop(syApp *app) {
+  int g = (int)(app->time / 3.0);
+  if (g != generation) {
+    generate(app, g);
+    generation = g;
+  }
+  syClear(app, SY_BLACK);
+  sySetColor(app, syHsvToRgb(syHsv(0.1, 0.5, 1, 0.8)));
+  syDrawPolylines(app, &mesh, lines, NUM_LINES, 1.5f);
+}
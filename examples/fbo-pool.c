@@ -0,0 +1,109 @@
+//
+// Example: fbo-pool.c
+// Description:
+// Moving dots leave fading trails in a pair of render targets held across
+// frames, and the trails are blurred by a chain of ten passes between two
+// temporary targets at half the window's size. All targets come from the app's
+// FBO pool, so nothing is allocated after the first frame.
+//
+
+#define SOYA_NO_CONFIGURE
+#include <soya/soya.h>
+
+#define NUM_DOTS 12
+#define NUM_BLUR_PASSES 10
+
+// clang-format off
+static const char *fs = SYSL(
+    SYSL_VERSION(430)
+    SYSL_FRAME_UNIFORMS
+    SYSL_OUT_VEC4(FragColor)
+    SYSL_UNIFORM(sampler2D, tex0)
+    SYSL_UNIFORM_VEC2(direction)
+    SYSL_UNIFORM_VEC2(size)
+    SYSL_UNIFORM_FLOAT(fade)
+    SYSL_MAIN(
+        vec2 uv = gl_FragCoord.xy / size;
+        vec2 d = direction / size;
+        vec4 c = texture(tex0, uv) * 0.4 +
+                 (texture(tex0, uv + d) + texture(tex0, uv - d)) * 0.3;
+        FragColor = vec4(c.rgb * fade, 1.);
+    )
+);
+// clang-format on
+
+static syShader shader;
+static syFboPingPong trails;
+
+static syFboOptions targetOptions(int width, int height) {
+  return (syFboOptions){.width = width,
+                        .height = height,
+                        .internalFormat = GL_RGBA8,
+                        .format = GL_RGBA,
+                        .type = GL_UNSIGNED_BYTE,
+                        .magFilter = GL_LINEAR,
+                        .minFilter = GL_LINEAR};
+}
+
+// Draws `source` into `target` through the blur shader. The quad covers the
+// window, which the viewport maps onto the whole target whatever its size.
+static void pass(syApp *app, syFbo *source, syFbo *target, float dx, float dy,
+                 float fade) {
+  syFboBegin(app, target);
+  syBeginShader(app, shader);
+  syBindTexture(app, 0, source->texture);
+  sySetUniform1i(app, "tex0", 0);
+  sySetUniform2f(app, "direction", dx, dy);
+  sySetUniform2f(app, "size", (float)target->options.width,
+                 (float)target->options.height);
+  sySetUniform1f(app, "fade", fade);
+  syDrawQuad(app, 0, 0, (float)app->width, (float)app->height);
+  syEndShader(app);
+  syFboEnd(app);
+}
+
+void setup(syApp *app) {
+  shader = syShaderProgramLoadFromSource(fs, NULL);
+  syFboOptions options = targetOptions(app->width, app->height);
+  trails = syAcquireFboPingPong(app, &options);
+  // Trails feed back into the next frame, so they are kept across frames
+  syHoldFbo(app, trails.read);
+  syHoldFbo(app, trails.write);
+  for (int i = 0; i < 2; i++) {
+    syFboBegin(app, trails.read);
+    syClear(app, SY_BLACK);
+    syFboEnd(app);
+    syFboPingPongSwap(&trails);
+  }
+}
+
+void loop(syApp *app) {
+  // Fade last frame's trails and draw the dots on top
+  pass(app, trails.read, trails.write, 0, 0, 0.96f);
+  syFboBegin(app, trails.write);
+  for (int i = 0; i < NUM_DOTS; i++) {
+    float t = (float)app->time * (0.5f + (float)i * 0.1f);
+    sySetColor(app, syHsvToRgb(syHsv((float)i / NUM_DOTS, 0.8, 1, 1)));
+    syDrawPolygon(app, app->width * (0.5f + 0.4f * cosf(t * 1.3f)),
+                  app->height * (0.5f + 0.4f * sinf(t)), 0, 12, 24);
+  }
+  syFboEnd(app);
+  syFboPingPongSwap(&trails);
+
+  // Blur the trails with temporary targets that are recycled next frame
+  syFboOptions options = targetOptions(app->width / 2, app->height / 2);
+  syFboPingPong blur = syAcquireFboPingPong(app, &options);
+  pass(app, trails.read, blur.write, 1, 0, 1);
+  for (int i = 1; i < NUM_BLUR_PASSES; i++) {
+    syFboPingPongSwap(&blur);
+    float radius = (float)(i / 2 + 1);
+    pass(app, blur.read, blur.write, i % 2 ? 0 : radius, i % 2 ? radius : 0,
+         1);
+  }
+  syDrawFbo(app, blur.write);
+
+  if (app->frameNum == 120) {
+    printf("Render targets created: %llu\n",
+           (unsigned long long)app->fboPool.numCreated);
+  }
+}
@@ -21,7 +21,7 @@ void setup(syApp *app) {
 }
 
 void loop(syApp *app) {
-  syClear(SY_BLACK);
+  syClear(app, SY_BLACK);
   syBeginShader(app, shader);
   syShaderUniform1f(shader, "time", glfwGetTime());
   syShaderUniform2f(shader, "res", app->width, app->height);
@@ -23,9 +23,9 @@ void setup(syApp *app) {
 }
 
 void loop(syApp *app) {
-  syFboBegin(&fbo);  // Begin drawing to the FBO
+  syFboBegin(app, &fbo);  // Begin drawing to the FBO
 
-  syClear(SY_CYAN);
+  syClear(app, SY_CYAN);
   sySetColor(app, SY_MAGENTA);
 
   int numPts = 80;
@@ -40,7 +40,7 @@ void loop(syApp *app) {
   syDrawLines(app, pts.data, pts.len / 3);
   syVecDestroy(pts);
 
-  syFboEnd();  // End drawing to the FBO
+  syFboEnd(app);  // End drawing to the FBO
 
   syDrawFbo(app, &fbo);  // Draw the FBO to the screen
 }
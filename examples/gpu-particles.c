@@ -0,0 +1,38 @@
+//
+// Example: gpu-particles.c
+// Description:
+// A million particles in a noise flow field, simulated in a compute shader.
+//
+
+#include <soya/soya.h>
+
+#define NUM_PARTICLES 1000000
+
+static syGpuParticles particles;
+
+void configure(syApp *app) {
+  app->width = 1200;
+  app->height = 800;
+}
+
+void setup(syApp *app) {
+  syGpuParticlesCreate(
+      &particles,
+      &(syGpuParticlesOptions){
+          .count = NUM_PARTICLES,
+          .spawnMin = {{0, 0, 0}},
+          .spawnMax = {{(float)app->width, (float)app->height, 0}},
+          .speed = 60,
+          .minLifetime = 1,
+          .maxLifetime = 4,
+          .noiseScale = 0.005f,
+          .noiseStrength = 1,
+      });
+}
+
+void loop(syApp *app) {
+  syClear(app, SY_BLACK);
+  syGpuParticlesUpdate(app, &particles, app->fps > 0 ? 1.f / app->fps : 0);
+  sySetColor(app, SY_WHITE);
+  syDrawGpuParticles(app, &particles);
+}
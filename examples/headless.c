@@ -0,0 +1,55 @@
+//
+// Example: headless.c
+// Description:
+// Renders variations of a polygon without showing a window and writes each
+// frame to a PPM image, as fast as the machine allows. Set `contextApi` to
+// `GLFW_OSMESA_CONTEXT_API` to render on machines without a display.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define SOYA_NO_SETUP
+#include <soya/soya.h>
+
+#define NUM_VARIATIONS 16
+
+void configure(syApp *app) {
+  app->width = 512;
+  app->height = 512;
+  app->headless = true;
+  app->frameLimit = NUM_VARIATIONS;
+}
+
+static void writePpm(const char *path, const unsigned char *pixels, int width,
+                     int height) {
+  FILE *f = fopen(path, "wb");
+  if (f == NULL) {
+    return;
+  }
+  fprintf(f, "P6\n%i %i\n255\n", width, height);
+  // Rows are read bottom to top
+  for (int y = height - 1; y >= 0; y--) {
+    fwrite(pixels + (size_t)y * width * 3, 3, (size_t)width, f);
+  }
+  fclose(f);
+}
+
+void loop(syApp *app) {
+  int variation = (int)app->frameNum;
+  syClear(app, SY_BLACK);
+  sySetColor(app, syHsvToRgb(syHsv((float)variation / NUM_VARIATIONS, 0.7,
+                                   1, 1)));
+  syDrawPolygon(app, app->width / 2.f, app->height / 2.f, 0, 200,
+                3 + variation);
+
+  syFlush(app);  // Submit batched draws before reading the pixels back
+  unsigned char *pixels = malloc((size_t)app->width * app->height * 3);
+  glPixelStorei(GL_PACK_ALIGNMENT, 1);
+  glReadPixels(0, 0, app->width, app->height, GL_RGB, GL_UNSIGNED_BYTE,
+               pixels);
+  char path[64];
+  snprintf(path, sizeof(path), "headless-%02i.ppm", variation);
+  writePpm(path, pixels, app->width, app->height);
+  free(pixels);
+}
@@ -0,0 +1,38 @@
+//
+// Example: instancing.c
+// Description:
+// Draws a grid of cubes with a single draw call. Each cube has its own
+// transformation matrix and color.
+//
+
+#define SOYA_NO_CONFIGURE
+#include <soya/soya.h>
+
+#define GRID_SIZE 40
+#define NUM_CUBES (GRID_SIZE * GRID_SIZE)
+
+static mat4s transforms[NUM_CUBES];
+static syColor colors[NUM_CUBES];
+
+void setup(syApp *app) {
+  sySetProjectionMatrix(app, syGetDefaultPerspective(app));
+  sySetViewMatrix(app, glms_lookat((vec3s){{0, 25, 30}}, (vec3s){{0, 0, 0}},
+                                   (vec3s){{0, 1, 0}}));
+  for (size_t i = 0; i < NUM_CUBES; i++) {
+    colors[i] = syHsvToRgb(syHsv((float)i / NUM_CUBES, 0.6, 1, 1));
+  }
+}
+
+void loop(syApp *app) {
+  syClear(app, SY_BLACK);
+  for (size_t i = 0; i < NUM_CUBES; i++) {
+    float x = (float)(i % GRID_SIZE) - GRID_SIZE * 0.5f;
+    float z = (float)(i / GRID_SIZE) - GRID_SIZE * 0.5f;
+    float y = sinf(x * 0.3f + (float)app->time) * cosf(z * 0.3f) * 2.f;
+    transforms[i] = glms_translate_make((vec3s){{x, y, z}});
+    transforms[i] = glms_rotate(transforms[i], (float)app->time + x * 0.1f,
+                                (vec3s){{1, 1, 0}});
+    transforms[i] = glms_scale(transforms[i], (vec3s){{0.6, 0.6, 0.6}});
+  }
+  syDrawCubeInstanced(app, transforms, colors, NUM_CUBES);
+}
@@ -0,0 +1,58 @@
+//
+// Example: mesh-pool.c
+// Description:
+// A few different meshes are packed into one `syMeshPool`. Every frame a grid
+// of them is drawn with `syDrawPooledMesh`, and all draws are submitted with a
+// single `glMultiDrawElementsIndirect` call.
+//
+
+#define SOYA_NO_CONFIGURE
+#include <soya/soya.h>
+
+#define GRID_SIZE 24
+#define NUM_SHAPES 3
+
+static syMeshPool pool;
+static uint32_t shapes[NUM_SHAPES];
+
+static const float tetrahedron[] = {1, 1, 1, -1, -1, 1, -1, 1, -1, 1, -1, -1};
+static const uint32_t tetrahedronIndices[] = {0, 1, 2, 0, 3, 1,
+                                              0, 2, 3, 1, 3, 2};
+
+static const float octahedron[] = {1, 0, 0, -1, 0, 0, 0, 1, 0,
+                                   0, -1, 0, 0, 0, 1, 0, 0, -1};
+static const uint32_t octahedronIndices[] = {0, 2, 4, 2, 1, 4, 1, 3, 4,
+                                             3, 0, 4, 2, 0, 5, 1, 2, 5,
+                                             3, 1, 5, 0, 3, 5};
+
+// Quad with its own vertex colors, drawn as two triangles
+static const float quad[] = {-1, -1, 0, 1, -1, 0, 1, 1, 0, -1, 1, 0};
+static const float quadColors[] = {1, 0, 0, 1, 0, 1, 0, 1,
+                                   0, 0, 1, 1, 1, 1, 0, 1};
+static const uint32_t quadIndices[] = {0, 1, 2, 0, 2, 3};
+
+void setup(syApp *app) {
+  sySetProjectionMatrix(app, syGetDefaultPerspective(app));
+  sySetViewMatrix(app, glms_lookat((vec3s){{0, 20, 26}}, (vec3s){{0, 0, 0}},
+                                   (vec3s){{0, 1, 0}}));
+  syMeshPoolInit(&pool);
+  shapes[0] = syMeshPoolAdd(&pool, tetrahedron, NULL, 4, tetrahedronIndices,
+                            12);
+  shapes[1] = syMeshPoolAdd(&pool, octahedron, NULL, 6, octahedronIndices,
+                            24);
+  shapes[2] = syMeshPoolAdd(&pool, quad, quadColors, 4, quadIndices, 6);
+}
+
+void loop(syApp *app) {
+  syClear(app, SY_BLACK);
+  sySetColor(app, syHsvToRgb(syHsv(0.55, 0.6, 1, 1)));
+  for (int i = 0; i < GRID_SIZE * GRID_SIZE; i++) {
+    float x = (float)(i % GRID_SIZE) - GRID_SIZE * 0.5f;
+    float z = (float)(i / GRID_SIZE) - GRID_SIZE * 0.5f;
+    mat4s model = glms_translate_make((vec3s){{x, 0, z}});
+    model = glms_rotate(model, (float)app->time + (x + z) * 0.2f,
+                        (vec3s){{0, 1, 0}});
+    model = glms_scale(model, (vec3s){{0.4, 0.4, 0.4}});
+    syDrawPooledMesh(app, &pool, shapes[i % NUM_SHAPES], model);
+  }
+}
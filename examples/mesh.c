@@ -0,0 +1,54 @@
+//
+// Example: mesh.c
+// Description:
+// A mesh is uploaded to the GPU once in `setup` and drawn every frame without
+// re-sending its vertices.
+//
+
+#define SOYA_NO_CONFIGURE
+#include <soya/soya.h>
+
+#define GRID 256
+
+syMesh terrain;
+
+void setup(syApp *app) {
+  sySetProjectionMatrix(app, syGetDefaultPerspective(app));
+  sySetViewMatrix(app, glms_lookat((vec3s){{0, 1.5, 2.5}}, (vec3s){{0, 0, 0}},
+                                   (vec3s){{0, 1, 0}}));
+
+  syVec(vec3s) positions;
+  syVec(syColor) colors;
+  syVec(uint32_t) indices;
+  syVecInit(positions, vec3s);
+  syVecInit(colors, syColor);
+  syVecInit(indices, uint32_t);
+  for (int z = 0; z < GRID; z++) {
+    for (int x = 0; x < GRID; x++) {
+      float fx = (float)x / (GRID - 1) * 2.f - 1.f;
+      float fz = (float)z / (GRID - 1) * 2.f - 1.f;
+      float y = sinf(fx * 6.f) * cosf(fz * 4.f) * 0.15f;
+      syVecPush(positions, ((vec3s){{fx, y, fz}}));
+      syVecPush(colors, syHsvToRgb(syHsv(y + 0.5f, 0.7, 1, 1)));
+    }
+  }
+  for (uint32_t z = 0; z < GRID - 1; z++) {
+    for (uint32_t x = 0; x < GRID - 1; x++) {
+      uint32_t i = z * GRID + x;
+      syVecPush3(indices, i, i + 1, i + GRID);
+      syVecPush3(indices, i + 1, i + GRID + 1, i + GRID);
+    }
+  }
+  syMeshCreateFromVecs(&app->renderer.gl, &terrain, positions, colors, indices,
+                       GL_TRIANGLES);
+  syVecDestroy(positions);
+  syVecDestroy(colors);
+  syVecDestroy(indices);
+}
+
+void loop(syApp *app) {
+  syClear(app, SY_BLACK);
+  syRotate(app, (float)app->time * 0.2f, 0, 1, 0);
+  syDrawMesh(app, &terrain);
+  syResetTransformations(app);
+}
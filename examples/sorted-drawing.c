@@ -0,0 +1,45 @@
+//
+// Example: sorted-drawing.c
+// Description:
+// Cubes and spheres are drawn alternately, which would switch meshes on every
+// draw. With sorted drawing, the draws are recorded and executed at the end of
+// the frame grouped by mesh. A blended overlay is drawn on top in call order.
+//
+
+#define SOYA_NO_CONFIGURE
+#include <soya/soya.h>
+
+#define GRID_SIZE 20
+
+void setup(syApp *app) {
+  sySetProjectionMatrix(app, syGetDefaultPerspective(app));
+  sySetViewMatrix(app, glms_lookat((vec3s){{0, 14, 18}}, (vec3s){{0, 0, 0}},
+                                   (vec3s){{0, 1, 0}}));
+  sySetSortedDrawing(app, true);
+}
+
+void loop(syApp *app) {
+  syClear(app, SY_BLACK);
+  for (int i = 0; i < GRID_SIZE * GRID_SIZE; i++) {
+    float x = (float)(i % GRID_SIZE) - GRID_SIZE * 0.5f;
+    float z = (float)(i / GRID_SIZE) - GRID_SIZE * 0.5f;
+    float y = sinf(x * 0.4f + (float)app->time) * 0.5f;
+    sySetColor(app, syHsvToRgb(syHsv((float)i / (GRID_SIZE * GRID_SIZE),
+                                     0.6, 1, 1)));
+    if (i % 2 == 0) {
+      syDrawCube(app, &(syCube){.center = {{x, y, z}}, .size = 0.5});
+    } else {
+      syDrawSphere(app, &(sySphere){.center = {{x, y, z}},
+                                    .radius = 0.3,
+                                    .resolution = 16});
+    }
+  }
+
+  // Blended draws keep their order
+  sySetBlend(app, true);
+  sySetDepthTest(app, false);
+  sySetColor(app, syRgb(0, 0, 0, 0.5));
+  syDrawCube(app, &(syCube){.center = {{0, 0, 0}}, .size = 4});
+  sySetDepthTest(app, true);
+  sySetBlend(app, false);
+}
@@ -0,0 +1,84 @@
+//
+// Example: threaded-drawing.c
+// Description:
+// A generative grid of rotating triangles whose rows are generated on several
+// threads. Each thread records into its own command list without making GL
+// calls, and the lists are merged and drawn before the buffers are swapped.
+//
+
+#include <pthread.h>
+
+#include <soya/soya.h>
+
+#define NUM_THREADS 4
+#define CELL_SIZE 8
+
+typedef struct Worker {
+  syCommandList list;
+  pthread_t thread;
+  int firstRow, numRows, numCols;
+  float time;
+} Worker;
+
+static Worker workers[NUM_THREADS];
+
+void configure(syApp *app) {
+  app->width = 1200;
+  app->height = 800;
+}
+
+static void *generate(void *arg) {
+  Worker *w = (Worker *)arg;
+  for (int row = w->firstRow; row < w->firstRow + w->numRows; row++) {
+    for (int col = 0; col < w->numCols; col++) {
+      float cx = ((float)col + 0.5f) * CELL_SIZE;
+      float cy = ((float)row + 0.5f) * CELL_SIZE;
+      float angle = w->time + (float)(row * col) * 0.01f;
+      float vertices[9];
+      for (int i = 0; i < 3; i++) {
+        float a = angle + (float)i * GLM_PI * 2 / 3;
+        vertices[i * 3] = cx + cosf(a) * CELL_SIZE * 0.5f;
+        vertices[i * 3 + 1] = cy + sinf(a) * CELL_SIZE * 0.5f;
+        vertices[i * 3 + 2] = 0;
+      }
+      syCommandListSetColor(
+          &w->list,
+          syHsvToRgb(syHsv(fmodf(angle * 0.1f, 1.f), 0.7, 1, 1)));
+      syCommandListDrawUnindexed(&w->list, vertices, NULL, 3, GL_TRIANGLES);
+    }
+  }
+  return NULL;
+}
+
+void onExit(void) {
+  for (int i = 0; i < NUM_THREADS; i++) {
+    syCommandListDestroy(&workers[i].list);
+  }
+}
+
+void setup(syApp *app) {
+  for (int i = 0; i < NUM_THREADS; i++) {
+    syCommandListInit(&workers[i].list);
+  }
+  app->onExit = onExit;
+}
+
+void loop(syApp *app) {
+  syClear(app, SY_BLACK);
+  int numRows = app->height / CELL_SIZE;
+  int rowsPerThread = (numRows + NUM_THREADS - 1) / NUM_THREADS;
+  for (int i = 0; i < NUM_THREADS; i++) {
+    Worker *w = &workers[i];
+    syBeginCommandList(app, &w->list);
+    w->firstRow = i * rowsPerThread;
+    w->numRows = w->firstRow + rowsPerThread < numRows
+                     ? rowsPerThread
+                     : numRows - w->firstRow;
+    w->numCols = app->width / CELL_SIZE;
+    w->time = (float)app->time;
+    pthread_create(&w->thread, NULL, generate, w);
+  }
+  for (int i = 0; i < NUM_THREADS; i++) {
+    pthread_join(workers[i].thread, NULL);
+  }
+}
@@ -1,7 +1,12 @@
 #pragma once
 
 #include <stdint.h>
+#include <stdbool.h>
 
+#include <soya/lib/framestats.h>
+#include <soya/core/fbo.h>
+#include <soya/core/hud.h>
+#include <soya/core/profile.h>
 #include <soya/core/defaults.h>
 #include <soya/core/renderer.h>
 
@@ -29,17 +34,66 @@ typedef struct syApp {
   // Number of samples used for multisampling. Default: 8
   int samples;
 
+  // Whether the app runs without showing a window, for batch rendering on
+  // machines without displays. Everything drawn to the window is drawn into
+  // `headlessTarget` instead, and the main loop runs as fast as possible.
+  // Default: false
+  bool headless;
+
+  // Framebuffer drawn into in headless mode, with a depth buffer and the size
+  // of the window. `glReadPixels` reads from it outside of `syFboBegin` and
+  // `syFboEnd`.
+  syFbo headlessTarget;
+
+  // Context creation API: `GLFW_NATIVE_CONTEXT_API`, `GLFW_EGL_CONTEXT_API` or
+  // `GLFW_OSMESA_CONTEXT_API`. In headless mode, EGL and OSMesa contexts are
+  // created without a display where GLFW supports it.
+  // Default: GLFW_NATIVE_CONTEXT_API
+  int contextApi;
+
+  // Number of frames after which the main loop exits, or 0 for no limit.
+  // Default: 0
+  uint64_t frameLimit;
+
+  // Frame rate of the offline clock, or 0 to follow the wall clock. When set,
+  // `time` advances by exactly `1 / offlineFps` seconds per frame, `fps` is
+  // `offlineFps` and vsync is off, so the app renders as fast as possible while
+  // producing frame-perfect output for encoders. Default: 0
+  int offlineFps;
+
   // Current frame number.
   uint64_t frameNum;
 
-  // Current frame rate.
+  // Current frame rate, from the duration of the last frame only. See
+  // `frameStats` for rolling statistics.
   float fps;
 
+  // Rolling statistics of the CPU time spent running `loop()`, swapping
+  // buffers and polling events, updated after every frame. Set
+  // `frameStats.reportInterval` and `frameStats.csvPath` in `configure()` to
+  // report them periodically.
+  syFrameStats frameStats;
+
+  // Scopes timed with `syProfileBegin` and `syProfileEnd`. The main loop times
+  // `loop()`, buffer swaps and event polling.
+  syProfiler profiler;
+
+  // File the profiled scopes are written to as a Chrome trace when the app
+  // exits, or `NULL`. Only used in builds with profiling. Default: `NULL`
+  const char *profileTracePath;
+
+  // Performance overlay with a frame-time graph and the renderer's counters,
+  // toggled with F3 by default. Change `hud.toggleKey` to use another key.
+  syHud hud;
+
   // Time in seconds since initialization.
   double time;
 
   syRenderer renderer;
 
+  // Temporary render targets handed out by `syAcquireFbo`
+  syFboPool fboPool;
+
   void (*onKey)(bool pressed, int key);
 
   void (*onMouseMove)(double x, double y);
@@ -56,6 +110,13 @@ static inline void syAppPreConfigure(syApp *app) {
   app->title = "";
   app->glVersionMajor = SY_DEFAULT_GL_VERSION_MAJOR;
   app->glVersionMinor = SY_DEFAULT_GL_VERSION_MINOR;
+  app->headless = false;
+  app->contextApi = GLFW_NATIVE_CONTEXT_API;
+  app->frameLimit = 0;
+  app->offlineFps = 0;
+  syFrameStatsInit(&app->frameStats);
+  app->profileTracePath = NULL;
+  syHudInit(&app->hud);
 }
 
 static inline void syAppDisableCursor(const syApp *const app) {
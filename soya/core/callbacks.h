@@ -13,8 +13,19 @@ static inline void syOnError(int error_code, const char *description) {
 
 static inline void syOnFrameBufferSize(GLFWwindow *window, int width,
                                        int height) {
-  (void)window;
-  glViewport(0, 0, width, height);
+  syApp *app = (syApp *)glfwGetWindowUserPointer(window);
+  syRenderer *r = &app->renderer;
+  // The headless target keeps its size
+  if (r->defaultFramebuffer != 0) {
+    return;
+  }
+  r->defaultWidth = width;
+  r->defaultHeight = height;
+  if (r->target == 0) {
+    r->targetWidth = width;
+    r->targetHeight = height;
+    syGlViewport(&r->gl, width, height);
+  }
 }
 static inline void syOnKey(GLFWwindow *window, int key, int scancode,
                            int action, int mods) {
@@ -28,6 +39,9 @@ static inline void syOnKey(GLFWwindow *window, int key, int scancode,
     if (key == GLFW_KEY_ESCAPE) {
       glfwSetWindowShouldClose(window, 1);
     }
+    if (key == app->hud.toggleKey) {
+      app->hud.visible = !app->hud.visible;
+    }
   } else if (action == GLFW_RELEASE && app->onKey != NULL) {
     app->onKey(false, key);
   }
@@ -79,8 +79,8 @@ static inline mat4s syGetDefaultPerspective(const syApp *const app) {
 }
 
 static inline void syCameraUpdate(syApp *app, syCamera *cam) {
-  app->renderer.viewMatrix = cam->view;
-  app->renderer.projectionMatrix = syGetDefaultPerspective(app);
+  syRendererSetViewMatrix(&app->renderer, cam->view);
+  syRendererSetProjectionMatrix(&app->renderer, syGetDefaultPerspective(app));
   vec3s right = glms_vec3_normalize(glms_vec3_cross(cam->dir, cam->up));
   float moveSpeed = 0.1;
   if (cam->wdown) {
@@ -0,0 +1,489 @@
+/**
+ * @file commands.h
+ *
+ * Draw commands recorded into a buffer, tagged with sort keys so that they can
+ * be reordered to minimize state changes before they are executed.
+ * */
+#ifndef _SOYA_COMMANDS_H
+#define _SOYA_COMMANDS_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include <soya/lib/vec.h>
+#include <soya/core/gl.h>
+#include <soya/core/mesh.h>
+#include <soya/core/frustum.h>
+#include <soya/glad/glad.h>
+
+#include <cglm/struct.h>
+
+// Offset of data that a command does not have
+#define SY_COMMAND_NO_DATA SIZE_MAX
+
+// Alignment of the data copied into a command buffer
+#define SY_COMMAND_DATA_ALIGNMENT 16
+
+// Number of passes a command buffer can hold before it must be executed
+#define SY_COMMAND_MAX_PASSES 256
+
+typedef enum syCommandType {
+  // Draws a retained `syMesh`
+  SY_COMMAND_MESH,
+  // Draws vertices copied into the command buffer
+  SY_COMMAND_STREAM,
+  // Draws meshes of a `syMeshPool` with one multi-draw call
+  SY_COMMAND_POOL,
+} syCommandType;
+
+/**
+ * A draw and the state it is made with. Stream commands refer to vertex data by
+ * its offset within the command buffer's data, so that they stay valid while
+ * the data grows.
+ * */
+typedef struct syCommand {
+  syCommandType type;
+  GLenum mode;
+  GLuint program, framebuffer;
+  // Size of the framebuffer, which the viewport is set to
+  GLsizei width, height;
+  // `SY_RENDER_STATE_*` bits
+  uint32_t renderState;
+  // Copy of the mesh, since meshes such as the renderer's cached primitives
+  // may move before the command is executed
+  syMesh mesh;
+  // 3 floats per vertex, 4 floats per color and 32-bit indices
+  size_t vertices, colors, indices;
+  uint32_t numVertices, numIndices;
+  // Pool drawn by pool commands, and `numDraws` indirect draw commands and
+  // transforms at `draws` and `transforms`. Their colors are at `colors`.
+  const syMeshPool *pool;
+  size_t draws, transforms;
+  uint32_t numDraws;
+  // Color of meshes or vertices without colors
+  float color[4];
+  mat4s modelViewProjectionMatrix;
+} syCommand;
+
+// Sort key of the command at `index`. `buffer` tells apart commands held by
+// different buffers when their keys are sorted together, with 0 standing for
+// the buffer the key was pushed to.
+typedef struct syCommandKey {
+  uint64_t key;
+  uint32_t index;
+  uint32_t buffer;
+} syCommandKey;
+
+/**
+ * Commands and the vertex data they draw, recorded without making any GL calls.
+ * Commands are recorded in passes, which end at barriers such as framebuffer
+ * changes. Sorting keeps the passes in order and orders the commands of each
+ * pass by render state, program and mesh. Ordered commands, which include
+ * every blended command, are drawn after the others in their pass and keep the
+ * order they were recorded in.
+ *
+ * @sa syCommandBufferPush, syCommandBufferBarrier, syCommandBufferSort
+ * */
+typedef struct syCommandBuffer {
+  syVec(syCommand) commands;
+  syVec(syCommandKey) keys;
+  syVec(syCommandKey) scratch;
+  syVec(uint8_t) data;
+  uint32_t sequence;
+  // Current pass and the number of keys pushed before it began
+  uint32_t pass;
+  size_t passBegin;
+  // Whether the current pass counts as not empty
+  bool passReserved;
+} syCommandBuffer;
+
+static inline void syCommandBufferInit(syCommandBuffer *cb) {
+  syVecInit(cb->commands, syCommand);
+  syVecInit(cb->keys, syCommandKey);
+  syVecInit(cb->scratch, syCommandKey);
+  syVecInit(cb->data, uint8_t);
+  cb->sequence = 0;
+  cb->pass = 0;
+  cb->passBegin = 0;
+  cb->passReserved = false;
+}
+
+static inline void syCommandBufferClear(syCommandBuffer *cb) {
+  cb->commands.len = 0;
+  cb->keys.len = 0;
+  cb->data.len = 0;
+  cb->sequence = 0;
+  cb->pass = 0;
+  cb->passBegin = 0;
+  cb->passReserved = false;
+}
+
+static inline void syCommandBufferDestroy(syCommandBuffer *cb) {
+  syVecDestroy(cb->commands);
+  syVecDestroy(cb->keys);
+  syVecDestroy(cb->scratch);
+  syVecDestroy(cb->data);
+}
+
+/**
+ * Copies `size` bytes of `data` into the command buffer.
+ * @returns the offset of the copy, or `SY_COMMAND_NO_DATA` if `data` is `NULL`.
+ * */
+static inline size_t syCommandBufferPushData(syCommandBuffer *cb,
+                                             const void *data, size_t size) {
+  if (data == NULL) {
+    return SY_COMMAND_NO_DATA;
+  }
+  size_t offset = (cb->data.len + SY_COMMAND_DATA_ALIGNMENT - 1) &
+                  ~(size_t)(SY_COMMAND_DATA_ALIGNMENT - 1);
+  size_t end = offset + size;
+  if (end > cb->data.cap) {
+    syVecReserve(cb->data, end > cb->data.cap * 2 ? end : cb->data.cap * 2);
+  }
+  memcpy(cb->data.data + offset, data, size);
+  cb->data.len = end;
+  return offset;
+}
+
+static inline const void *syCommandBufferData(const syCommandBuffer *cb,
+                                              size_t offset) {
+  return offset == SY_COMMAND_NO_DATA ? NULL : cb->data.data + offset;
+}
+
+/**
+ * @returns the sort key of `c`, the `sequence`th command recorded, in `pass`.
+ * From the most significant bit:
+ * - 8 bits pass
+ * - 1 bit set for ordered commands
+ * - for ordered commands, 55 bits sequence
+ * - otherwise 3 bits render state, 12 bits program, 16 bits vertex array and
+ *   24 bits sequence
+ * */
+static inline uint64_t syCommandKeyMake(const syCommand *c, bool ordered,
+                                        uint32_t pass, uint32_t sequence) {
+  uint64_t key = (uint64_t)(pass & 0xFF) << 56;
+  if (ordered || (c->renderState & SY_RENDER_STATE_BLEND)) {
+    return key | (uint64_t)1 << 55 | sequence;
+  }
+  GLuint vao = c->type == SY_COMMAND_MESH   ? c->mesh.vao
+               : c->type == SY_COMMAND_POOL ? c->pool->vao
+                                            : 0;
+  key |= (uint64_t)(c->renderState & 0x7) << 52;
+  key |= (uint64_t)(c->program & 0xFFF) << 40;
+  key |= (uint64_t)(vao & 0xFFFF) << 24;
+  return key | (sequence & 0xFFFFFF);
+}
+
+/**
+ * Appends the key of `c`, the `index`th command of the buffer numbered
+ * `buffer`, in `pass`, without copying the command. Used to sort the commands
+ * of several buffers together.
+ * */
+static inline void syCommandBufferPushKey(syCommandBuffer *cb,
+                                          const syCommand *c, bool ordered,
+                                          uint32_t pass, uint32_t index,
+                                          uint32_t buffer) {
+  syCommandKey key = {syCommandKeyMake(c, ordered, pass, cb->sequence++),
+                      index, buffer};
+  syVecPush(cb->keys, key);
+}
+
+/**
+ * Appends a copy of `c`. If `ordered` is `true`, the command is drawn in the
+ * order it was recorded in relative to other ordered commands.
+ * */
+static inline void syCommandBufferPush(syCommandBuffer *cb, const syCommand *c,
+                                       bool ordered) {
+  syCommandBufferPushKey(cb, c, ordered, cb->pass, (uint32_t)cb->commands.len,
+                         0);
+  syVecPush(cb->commands, *c);
+}
+
+/**
+ * Ends the current pass, so that commands pushed afterwards are executed after
+ * every command pushed before. Does nothing if the pass is empty.
+ * @returns false if all `SY_COMMAND_MAX_PASSES` passes are used, in which case
+ * the commands must be executed and cleared first.
+ * */
+static inline bool syCommandBufferBarrier(syCommandBuffer *cb) {
+  if (cb->keys.len == cb->passBegin && !cb->passReserved) {
+    return true;
+  }
+  if (cb->pass + 1 >= SY_COMMAND_MAX_PASSES) {
+    return false;
+  }
+  cb->pass++;
+  cb->passBegin = cb->keys.len;
+  cb->passReserved = false;
+  return true;
+}
+
+/**
+ * Keeps `syCommandBufferBarrier` from skipping the current pass while it is
+ * empty, for commands whose keys are pushed into it later.
+ * @returns the current pass.
+ * */
+static inline uint32_t syCommandBufferReservePass(syCommandBuffer *cb) {
+  cb->passReserved = true;
+  return cb->pass;
+}
+
+/**
+ * Sorts the keys of the recorded commands with a stable least significant
+ * digit radix sort, one byte per pass. Passes over bytes that are the same in
+ * every key are skipped.
+ * @returns the sorted keys.
+ * */
+static inline const syCommandKey *syCommandBufferSort(syCommandBuffer *cb) {
+  size_t n = cb->keys.len;
+  syVecReserve(cb->scratch, n);
+  syCommandKey *src = cb->keys.data, *dst = cb->scratch.data;
+  for (int shift = 0; shift < 64; shift += 8) {
+    size_t counts[256] = {0};
+    for (size_t i = 0; i < n; i++) {
+      counts[(src[i].key >> shift) & 0xFF]++;
+    }
+    if (n == 0 || counts[(src[0].key >> shift) & 0xFF] == n) {
+      continue;
+    }
+    size_t offset = 0;
+    for (size_t d = 0; d < 256; d++) {
+      size_t count = counts[d];
+      counts[d] = offset;
+      offset += count;
+    }
+    for (size_t i = 0; i < n; i++) {
+      dst[counts[(src[i].key >> shift) & 0xFF]++] = src[i];
+    }
+    syCommandKey *tmp = src;
+    src = dst;
+    dst = tmp;
+  }
+  return src;
+}
+
+/**
+ * Draws recorded by a worker thread without making GL calls, to be merged into
+ * the renderer's commands on the main thread. Only their keys are merged, and
+ * the commands are executed from the list's own buffer. The transformation,
+ * shader, framebuffer and render state are captured from the renderer when
+ * recording begins. Each list must only be used by one thread at a time.
+ *
+ * Consecutive unindexed draws of points, lines or triangles with the same
+ * transformation are collected into a single command.
+ *
+ * @sa syBeginCommandList, sySubmitCommandLists
+ * */
+typedef struct syCommandList {
+  syCommandBuffer buffer;
+  // Model view projection matrix of the renderer when recording began
+  mat4s base;
+  GLuint program, framebuffer;
+  GLsizei width, height;
+  uint32_t renderState;
+  bool ordered;
+  // Pass of the renderer's commands the list was begun in, which its commands
+  // are sorted into when it is merged
+  uint32_t pass;
+  // Whether mesh draws outside the view frustum are skipped, and the number of
+  // mesh draws skipped and recorded after being tested
+  bool culling;
+  uint64_t numCulled, numSubmitted;
+  // `base` multiplied by the model matrix set with
+  // `syCommandListSetTransform`
+  mat4s transform;
+  float color[4];
+  // Vertices collected for the next stream command
+  syVec(float) vertices;
+  syVec(float) colors;
+  GLenum mode;
+  bool constantColor;
+  float pendingColor[4];
+} syCommandList;
+
+static inline void syCommandListInit(syCommandList *l) {
+  *l = (syCommandList){0};
+  syCommandBufferInit(&l->buffer);
+  syVecInit(l->vertices, float);
+  syVecInit(l->colors, float);
+}
+
+static inline void syCommandListDestroy(syCommandList *l) {
+  syCommandBufferDestroy(&l->buffer);
+  syVecDestroy(l->vertices);
+  syVecDestroy(l->colors);
+}
+
+/**
+ * Clears the list and starts recording with the given state. Usually called
+ * through `syBeginCommandList`.
+ * */
+static inline void syCommandListReset(syCommandList *l, mat4s base,
+                                      GLuint program, GLuint framebuffer,
+                                      GLsizei width, GLsizei height,
+                                      uint32_t renderState, bool ordered,
+                                      bool culling, const float color[4]) {
+  syCommandBufferClear(&l->buffer);
+  l->vertices.len = 0;
+  l->colors.len = 0;
+  l->base = base;
+  l->transform = base;
+  l->program = program;
+  l->framebuffer = framebuffer;
+  l->width = width;
+  l->height = height;
+  l->renderState = renderState;
+  l->ordered = ordered;
+  l->culling = culling;
+  l->numCulled = 0;
+  l->numSubmitted = 0;
+  memcpy(l->color, color, sizeof(l->color));
+}
+
+static inline void syCommandListPush(syCommandList *l, syCommand *c) {
+  c->program = l->program;
+  c->framebuffer = l->framebuffer;
+  c->width = l->width;
+  c->height = l->height;
+  c->renderState = l->renderState;
+  c->modelViewProjectionMatrix = l->transform;
+  syCommandBufferPush(&l->buffer, c, l->ordered);
+}
+
+/**
+ * Turns the vertices collected so far into a stream command.
+ * */
+static inline void syCommandListFlush(syCommandList *l) {
+  size_t n = l->vertices.len / 3;
+  if (n == 0) {
+    return;
+  }
+  syCommandBuffer *cb = &l->buffer;
+  syCommand c = {
+      .type = SY_COMMAND_STREAM,
+      .mode = l->mode,
+      .vertices = syCommandBufferPushData(cb, l->vertices.data,
+                                          sizeof(float) * n * 3),
+      .colors = l->constantColor
+                    ? SY_COMMAND_NO_DATA
+                    : syCommandBufferPushData(cb, l->colors.data,
+                                              sizeof(float) * n * 4),
+      .indices = SY_COMMAND_NO_DATA,
+      .numVertices = (uint32_t)n};
+  memcpy(c.color, l->pendingColor, sizeof(c.color));
+  syCommandListPush(l, &c);
+  l->vertices.len = 0;
+  l->colors.len = 0;
+}
+
+/**
+ * Places the following draws by `model` on top of the renderer's
+ * transformations when recording began.
+ * */
+static inline void syCommandListSetTransform(syCommandList *l, mat4s model) {
+  syCommandListFlush(l);
+  l->transform = glms_mul(l->base, model);
+}
+
+static inline void syCommandListSetColor(syCommandList *l, syColor col) {
+  memcpy(l->color, (float *)&col, sizeof(l->color));
+}
+
+/**
+ * Records `n` vertices. `colors` holds 4 floats per vertex and may be `NULL`,
+ * in which case the list's color is used.
+ * */
+static inline void syCommandListDrawUnindexed(syCommandList *l,
+                                              const float *vertices,
+                                              const float *colors, size_t n,
+                                              GLenum mode) {
+  bool mergeable =
+      mode == GL_POINTS || mode == GL_LINES || mode == GL_TRIANGLES;
+  if (l->vertices.len > 0 && (!mergeable || l->mode != mode)) {
+    syCommandListFlush(l);
+  }
+  if (l->vertices.len == 0) {
+    l->mode = mode;
+    l->constantColor = colors == NULL;
+    memcpy(l->pendingColor, l->color, sizeof(l->color));
+  } else if (l->constantColor &&
+             (colors != NULL ||
+              memcmp(l->pendingColor, l->color, sizeof(l->color)) != 0)) {
+    // Expand the constant color to the vertices collected so far
+    size_t collected = l->vertices.len / 3;
+    l->colors.len = 0;
+    for (size_t i = 0; i < collected; i++) {
+      syVecPushArr(l->colors, l->pendingColor, 4);
+    }
+    l->constantColor = false;
+  }
+  syVecPushArr(l->vertices, vertices, n * 3);
+  if (!l->constantColor) {
+    if (colors != NULL) {
+      syVecPushArr(l->colors, colors, n * 4);
+    } else {
+      for (size_t i = 0; i < n; i++) {
+        syVecPushArr(l->colors, l->color, 4);
+      }
+    }
+  }
+  if (!mergeable) {
+    syCommandListFlush(l);
+  }
+}
+
+/**
+ * Records an indexed draw. `colors` may be `NULL`.
+ * */
+static inline void syCommandListDrawIndexed(syCommandList *l,
+                                            const float *vertices,
+                                            const float *colors,
+                                            const uint32_t *indices,
+                                            size_t numVertices,
+                                            size_t numIndices, GLenum mode) {
+  syCommandListFlush(l);
+  syCommandBuffer *cb = &l->buffer;
+  syCommand c = {
+      .type = SY_COMMAND_STREAM,
+      .mode = mode,
+      .vertices = syCommandBufferPushData(cb, vertices,
+                                          sizeof(float) * numVertices * 3),
+      .colors = syCommandBufferPushData(cb, colors,
+                                        sizeof(float) * numVertices * 4),
+      .indices = syCommandBufferPushData(cb, indices,
+                                         sizeof(uint32_t) * numIndices),
+      .numVertices = (uint32_t)numVertices,
+      .numIndices = (uint32_t)numIndices};
+  memcpy(c.color, l->color, sizeof(c.color));
+  syCommandListPush(l, &c);
+}
+
+/**
+ * Records a draw of `mesh`, placed by `model` on top of the current transform
+ * if it is not `NULL`. Meshes outside the view frustum when recording began are
+ * skipped if culling was on.
+ * */
+static inline void syCommandListDrawMesh(syCommandList *l, const syMesh *mesh,
+                                         const mat4s *model) {
+  syCommandListFlush(l);
+  mat4s mvp = model == NULL ? l->transform : glms_mul(l->transform, *model);
+  if (l->culling) {
+    syFrustum frustum = syFrustumFromMatrix(mvp);
+    bool visible = syFrustumTestAabb(&frustum, &mesh->bounds);
+    l->numCulled += !visible;
+    l->numSubmitted += visible;
+    if (!visible) {
+      return;
+    }
+  }
+  syCommand c = {.type = SY_COMMAND_MESH, .mesh = *mesh};
+  memcpy(c.color, l->color, sizeof(c.color));
+  mat4s transform = l->transform;
+  l->transform = mvp;
+  syCommandListPush(l, &c);
+  l->transform = transform;
+}
+
+#endif  // _SOYA_COMMANDS_H
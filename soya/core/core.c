@@ -1 +1,3 @@
 #include "core.h"
+
+syGlState *syGlCurrentState = NULL;
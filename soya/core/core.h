@@ -2,8 +2,13 @@
 
 #include <soya/core/gl.h>
 #include <soya/core/app.h>
+#include <soya/core/hud.h>
 #include <soya/core/fbo.h>
+#include <soya/core/mesh.h>
+#include <soya/core/commands.h>
+#include <soya/core/frustum.h>
 #include <soya/core/camera.h>
+#include <soya/core/gpuparticles.h>
 #include <soya/core/shader.h>
 #include <soya/core/rendering.h>
 #include <soya/core/renderer.h>
@@ -6,5 +6,10 @@
 #define SY_DEFAULT_WINDOW_WIDTH 1280
 #define SY_DEFAULT_WINDOW_HEIGHT 720
 #define SY_DEFAULT_WINDOW_SAMPLES 8
+#define SY_DEFAULT_BATCH_CAPACITY 65536
+#define SY_DEFAULT_STREAM_BUFFER_SIZE (8 * 1024 * 1024)
+#define SY_MAX_SHADER_PROGRAMS 256
+#define SY_POLYGON_STACK_VERTICES 130
+#define SY_MATRIX_STACK_DEPTH 32
 
 #endif  // _SOYA_DEFAULT_H
@@ -32,6 +32,40 @@ static const char *SY_DEFAULT_VERTEX_SHADER =
     "   vColor = aColor;\n"
     "}\0";
 
+// Vertex shader used for instanced draws. Each instance has its own model
+// matrix, which is applied before the renderer's transformations, and color,
+// which is multiplied with the vertex color.
+//
+// Attributes:
+// - location 0 - vec3 aPos
+// - location 1 - vec4 aColor
+// - location 2 - vec4 aInstanceColor (per instance)
+// - location 3 - mat4 aInstanceModel (per instance, occupies locations 3-6)
+//
+// Uniforms:
+// - mat4 modelViewProjectionMatrix
+//
+// Outputs:
+// - vec4 vColor
+// - vec4 vPos
+static const char *SY_DEFAULT_INSTANCED_VERTEX_SHADER =
+    "#version 430 core\n"
+    "layout (location = 0) in vec3 aPos;\n"
+    "layout (location = 1) in vec4 aColor;\n"
+    "layout (location = 2) in vec4 aInstanceColor;\n"
+    "layout (location = 3) in mat4 aInstanceModel;\n"
+    "uniform mat4 modelViewProjectionMatrix;\n"
+    "out vec4 vColor;\n"
+    "out vec4 vPos; \n"
+    "void main()\n"
+    "{\n"
+    "   vec4 outPos = modelViewProjectionMatrix * aInstanceModel * "
+    "vec4(aPos, 1.0);\n"
+    "   gl_Position = outPos;\n"
+    "   vPos = outPos;\n"
+    "   vColor = aColor * aInstanceColor;\n"
+    "}\0";
+
 // Inputs:
 // - vec4 vColor
 //
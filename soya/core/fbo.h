@@ -1,35 +1,91 @@
 #ifndef _SOYA_FBO_H
 #define _SOYA_FBO_H
 
-#include <soya/core/shader.h>
-#include <soya/glad/glad.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdbool.h>
 
-typedef struct syFbo {
-  GLuint framebuffer;
-  GLuint texture;
-  GLenum format;
-  syShader shader;
-} syFbo;
+#include <soya/lib/sl.h>
+#include <soya/lib/vec.h>
+#include <soya/glad/glad.h>
 
 typedef struct syFboOptions {
   int width, height;
   GLenum internalFormat, format, type;
   GLint magFilter, minFilter;
+  // Whether a depth buffer is attached, for depth tested drawing
+  bool depth;
 } syFboOptions;
 
+typedef struct syFbo {
+  GLuint framebuffer;
+  GLuint texture;
+  // Depth renderbuffer, or 0
+  GLuint depth;
+  GLenum format;
+  // Options the FBO was created with
+  syFboOptions options;
+} syFbo;
+
+// Draws the first `channels` channels of `tex0`. One channel is drawn as gray,
+// and alpha is only drawn from four channels.
 static const char *SY_RGB_FBO_FRAGMENT_SHADER =
     "#version 430 core\n"
+    SYSL_FRAME_UNIFORMS
     "out vec4 color;\n"
     "uniform sampler2D tex0;\n"
-    "uniform vec2 res;"
+    "uniform int channels;\n"
     "void main()\n"
     "{\n"
-    "  vec2 UV = gl_FragCoord.xy / res;"
-    "  color = vec4(texture(tex0, UV).xyz,1.0);"
+    "  vec2 UV = gl_FragCoord.xy / syResolution;"
+    "  vec4 texel = texture(tex0, UV);"
+    "  if (channels == 1) {"
+    "    color = vec4(texel.rrr, 1.0);"
+    "  } else if (channels == 2) {"
+    "    color = vec4(texel.rg, 0.0, 1.0);"
+    "  } else {"
+    "    color = vec4(texel.rgb, channels == 4 ? texel.a : 1.0);"
+    "  }"
     "}\n\0";
 
+// @returns the number of color channels of textures with `internalFormat`.
+// Formats with 3 channels, and formats that are not color formats, give 3.
+static inline int syFboChannels(GLenum internalFormat) {
+  switch (internalFormat) {
+    case GL_RED:
+    case GL_R8:
+    case GL_R16:
+    case GL_R16F:
+    case GL_R32F:
+      return 1;
+    case GL_RG:
+    case GL_RG8:
+    case GL_RG16:
+    case GL_RG16F:
+    case GL_RG32F:
+      return 2;
+    case GL_RGBA:
+    case GL_RGBA8:
+    case GL_RGBA16:
+    case GL_RGBA16F:
+    case GL_RGBA32F:
+    case GL_SRGB8_ALPHA8:
+    case GL_RGB10_A2:
+      return 4;
+    default:
+      return 3;
+  }
+}
+
+// Creates a framebuffer with a color texture attached. The framebuffer and
+// texture bindings and the viewport are restored afterwards.
 static inline syFbo syFboCreate(syFboOptions *options) {
   syFbo fbo;
+  fbo.options = *options;
+  GLint prevFramebuffer = 0, prevTexture = 0, prevViewport[4] = {0};
+  glGetIntegerv(GL_FRAMEBUFFER_BINDING, &prevFramebuffer);
+  glGetIntegerv(GL_TEXTURE_BINDING_2D, &prevTexture);
+  glGetIntegerv(GL_VIEWPORT, prevViewport);
   // Generate framebuffer
   glGenFramebuffers(1, &fbo.framebuffer);
   glBindFramebuffer(GL_FRAMEBUFFER, fbo.framebuffer);
@@ -45,32 +101,210 @@ static inline syFbo syFboCreate(syFboOptions *options) {
   glTexImage2D(GL_TEXTURE_2D, 0, (GLint)options->internalFormat, options->width,
                options->height, 0, format, options->type, 0);
 
-  GLint magFilter = options->magFilter == 0 ? GL_NEAREST : options->minFilter;
+  GLint magFilter = options->magFilter == 0 ? GL_NEAREST : options->magFilter;
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, magFilter);
 
-  GLint minFilter = options->magFilter == 0 ? GL_NEAREST : options->minFilter;
+  GLint minFilter = options->minFilter == 0 ? GL_NEAREST : options->minFilter;
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, minFilter);
 
   // Attach texture to Framebuffer's Color Attachment 0
   glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, fbo.texture, 0);
 
+  fbo.depth = 0;
+  if (options->depth) {
+    GLint prevRenderbuffer = 0;
+    glGetIntegerv(GL_RENDERBUFFER_BINDING, &prevRenderbuffer);
+    glGenRenderbuffers(1, &fbo.depth);
+    glBindRenderbuffer(GL_RENDERBUFFER, fbo.depth);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, options->width,
+                          options->height);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,
+                              GL_RENDERBUFFER, fbo.depth);
+    glBindRenderbuffer(GL_RENDERBUFFER, (GLuint)prevRenderbuffer);
+  }
+
   // Enable drawing to color attachment 0
   GLenum drawBuffers[1] = {GL_COLOR_ATTACHMENT0};
   glDrawBuffers(1, drawBuffers);
 
-  // Set viewport of framebuffer
-  glViewport(0, 0, options->width, options->height);
-
-  // Bind default framebuffer and texture
-  glBindFramebuffer(GL_FRAMEBUFFER, 0);
-  glBindTexture(GL_TEXTURE_2D, 0);
+  // Restore previous framebuffer, texture and viewport
+  glBindFramebuffer(GL_FRAMEBUFFER, (GLuint)prevFramebuffer);
+  glBindTexture(GL_TEXTURE_2D, (GLuint)prevTexture);
+  glViewport(prevViewport[0], prevViewport[1], prevViewport[2],
+             prevViewport[3]);
 
-  // TODO: Handle other FBO texture formats
-  fbo.shader = syShaderProgramLoadFromSource(SY_RGB_FBO_FRAGMENT_SHADER,
-                                             SY_DEFAULT_VERTEX_SHADER);
+  fbo.format = format;
   /* assert(glCheckFramebufferStatus(GL_FRAMEBUFFER) ==
    * GL_FRAMEBUFFER_COMPLETE); */
   return fbo;
 }
 
+// Deletes the framebuffer, texture and depth buffer without telling the
+// renderer. Use `syDestroyFbo` instead.
+static inline void _syFboDestroy(syFbo *fbo) {
+  glDeleteFramebuffers(1, &fbo->framebuffer);
+  glDeleteTextures(1, &fbo->texture);
+  if (fbo->depth != 0) {
+    glDeleteRenderbuffers(1, &fbo->depth);
+  }
+  fbo->framebuffer = fbo->texture = fbo->depth = 0;
+}
+
+// Whether FBOs created with `a` and `b` are interchangeable
+static inline bool syFboOptionsEqual(const syFboOptions *a,
+                                     const syFboOptions *b) {
+  return a->width == b->width && a->height == b->height &&
+         a->internalFormat == b->internalFormat && a->format == b->format &&
+         a->type == b->type && a->magFilter == b->magFilter &&
+         a->minFilter == b->minFilter && a->depth == b->depth;
+}
+
+// Frames a pooled FBO may stay unused before it is deleted
+#define SY_FBO_POOL_MAX_IDLE_FRAMES 60
+
+typedef struct syFboPoolEntry {
+  syFbo fbo;
+  // Whether the FBO is handed out, and whether it stays handed out across
+  // frames until it is released
+  bool inUse, held;
+  uint64_t lastUsed;
+} syFboPoolEntry;
+
+/**
+ * Recycles temporary render targets. FBOs acquired from the pool are handed
+ * out until the next frame begins, or until they are released, and are reused
+ * by later acquisitions with the same options. FBOs unused for
+ * `SY_FBO_POOL_MAX_IDLE_FRAMES` frames are deleted. Once every size and format
+ * a frame uses has been created, acquiring allocates nothing.
+ * */
+typedef struct syFboPool {
+  // Allocated one by one so that acquired FBOs never move
+  syVec(syFboPoolEntry *) entries;
+  uint64_t frame;
+  // Number of FBOs the pool has created
+  uint64_t numCreated;
+} syFboPool;
+
+/**
+ * Two targets for passes that read the result of the previous pass. Draw into
+ * `write` while sampling `read`, then swap them with `syFboPingPongSwap`.
+ * */
+typedef struct syFboPingPong {
+  syFbo *read, *write;
+} syFboPingPong;
+
+static inline void syFboPoolInit(syFboPool *pool) {
+  syVecInit(pool->entries, syFboPoolEntry *);
+  pool->frame = 0;
+  pool->numCreated = 0;
+}
+
+/**
+ * @returns an FBO created with `options` that nothing else uses this frame,
+ * creating one if none is free. The returned pointer stays valid until the FBO
+ * is deleted by the pool.
+ * */
+static inline syFbo *syFboPoolAcquire(syFboPool *pool,
+                                      const syFboOptions *options) {
+  syFboPoolEntry *entry = NULL;
+  SY_VEC_FOREACH(pool->entries, i) {
+    syFboPoolEntry *e = pool->entries.data[i];
+    if (!e->inUse && syFboOptionsEqual(&e->fbo.options, options)) {
+      entry = e;
+      break;
+    }
+  }
+  if (entry == NULL) {
+    entry = (syFboPoolEntry *)malloc(sizeof(syFboPoolEntry));
+    syFboOptions o = *options;
+    entry->fbo = syFboCreate(&o);
+    entry->held = false;
+    syVecPush(pool->entries, entry);
+    pool->numCreated++;
+  }
+  entry->inUse = true;
+  entry->lastUsed = pool->frame;
+  return &entry->fbo;
+}
+
+static inline syFboPoolEntry *syFboPoolFind(syFboPool *pool,
+                                            const syFbo *fbo) {
+  SY_VEC_FOREACH(pool->entries, i) {
+    if (&pool->entries.data[i]->fbo == fbo) {
+      return pool->entries.data[i];
+    }
+  }
+  return NULL;
+}
+
+/**
+ * Keeps `fbo`, acquired from `pool`, handed out across frames until it is
+ * released, for targets that feed back into the next frame.
+ * */
+static inline void syFboPoolHold(syFboPool *pool, const syFbo *fbo) {
+  syFboPoolEntry *e = syFboPoolFind(pool, fbo);
+  if (e != NULL) {
+    e->held = true;
+  }
+}
+
+// Returns `fbo` to the pool before the frame ends.
+static inline void syFboPoolRelease(syFboPool *pool, const syFbo *fbo) {
+  syFboPoolEntry *e = syFboPoolFind(pool, fbo);
+  if (e != NULL) {
+    e->inUse = false;
+    e->held = false;
+  }
+}
+
+static inline syFboPingPong syFboPoolAcquirePingPong(
+    syFboPool *pool, const syFboOptions *options) {
+  syFboPingPong p;
+  p.read = syFboPoolAcquire(pool, options);
+  p.write = syFboPoolAcquire(pool, options);
+  return p;
+}
+
+static inline void syFboPingPongSwap(syFboPingPong *p) {
+  syFbo *read = p->read;
+  p->read = p->write;
+  p->write = read;
+}
+
+/**
+ * Takes back the FBOs handed out last frame that are not held and deletes the
+ * ones that have been idle for too long. Called by `main.h` before every
+ * `loop()`.
+ * @returns whether any FBO was deleted.
+ * */
+static inline bool syFboPoolBeginFrame(syFboPool *pool) {
+  bool deleted = false;
+  pool->frame++;
+  for (size_t i = 0; i < pool->entries.len;) {
+    syFboPoolEntry *e = pool->entries.data[i];
+    if (e->inUse && e->held) {
+      e->lastUsed = pool->frame;
+    }
+    e->inUse = e->inUse && e->held;
+    if (!e->inUse &&
+        pool->frame - e->lastUsed > SY_FBO_POOL_MAX_IDLE_FRAMES) {
+      _syFboDestroy(&e->fbo);
+      free(e);
+      pool->entries.data[i] = pool->entries.data[--pool->entries.len];
+      deleted = true;
+      continue;
+    }
+    i++;
+  }
+  return deleted;
+}
+
+static inline void syFboPoolDestroy(syFboPool *pool) {
+  SY_VEC_FOREACH(pool->entries, i) {
+    _syFboDestroy(&pool->entries.data[i]->fbo);
+    free(pool->entries.data[i]);
+  }
+  syVecDestroy(pool->entries);
+}
+
 #endif
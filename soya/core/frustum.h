@@ -0,0 +1,127 @@
+/**
+ * @file frustum.h
+ *
+ * View frustum extraction and bounding volume tests used to skip geometry that
+ * cannot be seen.
+ * */
+#ifndef _SOYA_FRUSTUM_H
+#define _SOYA_FRUSTUM_H
+
+#include <math.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#include <cglm/struct.h>
+
+/**
+ * Axis-aligned bounding box.
+ * */
+typedef struct syAabb {
+  vec3s min, max;
+} syAabb;
+
+/**
+ * Left, right, bottom, top, near and far planes of a view frustum. A point `p`
+ * is inside a plane if `dot(plane.xyz, p) + plane.w >= 0`. The planes are
+ * normalized, so the left-hand side is the distance to the plane.
+ * */
+typedef struct syFrustum {
+  vec4s planes[6];
+} syFrustum;
+
+/**
+ * Extracts the frustum planes of the transformation `m`. If `m` is a model view
+ * projection matrix, the planes are in model space.
+ * */
+static inline syFrustum syFrustumFromMatrix(mat4s m) {
+  syFrustum f;
+  for (int i = 0; i < 6; i++) {
+    int row = i / 2;
+    float sign = i % 2 == 0 ? 1.f : -1.f;
+    vec4s p;
+    for (int col = 0; col < 4; col++) {
+      p.raw[col] = m.raw[col][3] + sign * m.raw[col][row];
+    }
+    float len = sqrtf(p.x * p.x + p.y * p.y + p.z * p.z);
+    for (int j = 0; j < 4; j++) {
+      p.raw[j] = len > 0 ? p.raw[j] / len : p.raw[j];
+    }
+    f.planes[i] = p;
+  }
+  return f;
+}
+
+/**
+ * @returns `true` if the sphere at `center` with `radius` is at least partially
+ * inside the frustum.
+ * */
+static inline bool syFrustumTestSphere(const syFrustum *f, vec3s center,
+                                       float radius) {
+  for (int i = 0; i < 6; i++) {
+    const vec4s *p = &f->planes[i];
+    if (p->x * center.x + p->y * center.y + p->z * center.z + p->w <
+        -radius) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * @returns `true` if the box is at least partially inside the frustum. Boxes
+ * that straddle the corner of two planes outside the frustum may be reported
+ * as visible.
+ * */
+static inline bool syFrustumTestAabb(const syFrustum *f, const syAabb *box) {
+  for (int i = 0; i < 6; i++) {
+    const vec4s *p = &f->planes[i];
+    // Corner of the box furthest along the plane's normal
+    float x = p->x >= 0 ? box->max.x : box->min.x;
+    float y = p->y >= 0 ? box->max.y : box->min.y;
+    float z = p->z >= 0 ? box->max.z : box->min.z;
+    if (p->x * x + p->y * y + p->z * z + p->w < 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * @returns the bounding box of `n` points stored as 3 floats each.
+ * */
+static inline syAabb syAabbFromPoints(const float *points, size_t n) {
+  if (n == 0) {
+    return (syAabb){0};
+  }
+  syAabb box = {.min = {{points[0], points[1], points[2]}},
+                .max = {{points[0], points[1], points[2]}}};
+  for (size_t i = 1; i < n; i++) {
+    for (int a = 0; a < 3; a++) {
+      float v = points[i * 3 + a];
+      box.min.raw[a] = v < box.min.raw[a] ? v : box.min.raw[a];
+      box.max.raw[a] = v > box.max.raw[a] ? v : box.max.raw[a];
+    }
+  }
+  return box;
+}
+
+/**
+ * @returns the axis-aligned box enclosing `box` transformed by `m`.
+ * */
+static inline syAabb syAabbTransform(const syAabb *box, mat4s m) {
+  syAabb out;
+  for (int row = 0; row < 3; row++) {
+    float lo = m.raw[3][row], hi = m.raw[3][row];
+    for (int col = 0; col < 3; col++) {
+      float a = m.raw[col][row] * box->min.raw[col];
+      float b = m.raw[col][row] * box->max.raw[col];
+      lo += a < b ? a : b;
+      hi += a < b ? b : a;
+    }
+    out.min.raw[row] = lo;
+    out.max.raw[row] = hi;
+  }
+  return out;
+}
+
+#endif  // _SOYA_FRUSTUM_H
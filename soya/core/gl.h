@@ -7,19 +7,286 @@
 #define _SOYA_GL_H_
 
 #include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <soya/core/defaults.h>
 #include <soya/glad/glad.h>
 
-static inline void syWriteBuffer(GLenum target, GLuint buffer, GLsizeiptr size,
-                                 const void *data, GLenum usage) {
+// glBufferStorage is part of GL 4.4 / ARB_buffer_storage, which the bundled
+// glad loader does not cover. It is resolved at runtime when available.
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#endif
+#ifndef GL_MAP_COHERENT_BIT
+#define GL_MAP_COHERENT_BIT 0x0080
+#endif
+
+typedef void(APIENTRYP syPFNGLBUFFERSTORAGEPROC)(GLenum target,
+                                                 GLsizeiptr size,
+                                                 const void *data,
+                                                 GLbitfield flags);
+
+#define SY_GL_STATE_UNKNOWN 0xFFFFFFFFu
+#define SY_GL_STATE_TEXTURE_UNITS 16
+
+// Bits of the fixed-function state set by `syGlSetRenderState`
+#define SY_RENDER_STATE_DEPTH_TEST 0x1
+// Alpha blending with `GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA`
+#define SY_RENDER_STATE_BLEND 0x2
+
+#define SY_RING_BUFFER_SECTIONS 3
+#define SY_RING_BUFFER_ALIGNMENT 16
+
+// Work submitted to GL during a frame. The renderer resets it every frame.
+typedef struct syRenderStats {
+  uint64_t drawCalls;
+  // Vertices fetched by draw calls, counting every index of indexed draws and
+  // every instance
+  uint64_t vertices;
+  uint64_t primitives;
+  // Bytes of vertices, indices, instance attributes, indirect commands and
+  // frame uniforms streamed to the GPU, and of meshes uploaded
+  uint64_t bytesUploaded;
+  uint64_t programSwitches;
+  uint64_t framebufferBinds;
+  // Uniform values sent by the `syShaderUniform*` functions
+  uint64_t uniformUploads;
+  // Binds skipped because the object was already bound
+  uint64_t elidedBinds;
+  // Draws skipped and made after being tested against the view frustum
+  uint64_t culled, submitted;
+} syRenderStats;
+
+// @returns the number of primitives that `n` vertices make in `mode`.
+static inline uint64_t syPrimitiveCount(GLenum mode, uint64_t n) {
+  switch (mode) {
+    case GL_POINTS:
+      return n;
+    case GL_LINES:
+      return n / 2;
+    case GL_LINE_STRIP:
+      return n > 1 ? n - 1 : 0;
+    case GL_LINE_LOOP:
+      return n > 1 ? n : 0;
+    case GL_TRIANGLES:
+      return n / 3;
+    case GL_TRIANGLE_STRIP:
+    case GL_TRIANGLE_FAN:
+      return n > 2 ? n - 2 : 0;
+    default:
+      return 0;
+  }
+}
+
+// A uniform's cached location and a shadow copy of the value last sent to it.
+typedef struct syUniform {
+  uint32_t hash;
+  char *name;
+  GLint location;
+  bool set;
+  unsigned char value[64];
+} syUniform;
+
+// Uniforms of a program, reflected when it is linked or first used.
+typedef struct syUniformTable {
+  GLuint program;
+  size_t len, cap;
+  syUniform *uniforms;
+} syUniformTable;
+
+// Shadow copy of the GL bindings made through the `syGl*` functions below, used
+// to skip calls that would not change anything. Bindings made with raw GL calls
+// are not seen, so call `syGlStateInvalidate` after making any.
+typedef struct syGlState {
+  GLuint program, vertexArray, arrayBuffer, elementArrayBuffer, framebuffer;
+  GLuint textures[SY_GL_STATE_TEXTURE_UNITS];
+  // `SY_RENDER_STATE_*` bits
+  uint32_t renderState;
+  // Size of the viewport, which always starts at the origin, or -1 if unknown
+  GLsizei viewportWidth, viewportHeight;
+  // Number of calls skipped because the binding was already current.
+  uint64_t elided;
+  // Counters of the current frame. Draws are counted with `syGlCountDraw`.
+  syRenderStats stats;
+  // `SY_MAX_SHADER_PROGRAMS` uniform tables, indexed by program name with
+  // linear probing, used by the `syShaderUniform*` functions. Values set with
+  // raw `glUniform*` calls bypass the shadow copies, so mixing them with the
+  // `syShaderUniform*` functions on the same uniform is not supported.
+  syUniformTable *uniformTables;
+} syGlState;
+
+// State of the current GL context, which functions without a `syGlState`
+// parameter such as `syShaderUniform1f` use. Set by `syGlStateMakeCurrent`, and
+// `NULL` until then. Defined in core.c.
+extern syGlState *syGlCurrentState;
+
+static inline void syGlStateMakeCurrent(syGlState *s) { syGlCurrentState = s; }
+
+// Forgets all bindings so that the next call to each `syGl*` function is made.
+static inline void syGlStateInvalidate(syGlState *s) {
+  s->program = SY_GL_STATE_UNKNOWN;
+  s->vertexArray = SY_GL_STATE_UNKNOWN;
+  s->arrayBuffer = SY_GL_STATE_UNKNOWN;
+  s->elementArrayBuffer = SY_GL_STATE_UNKNOWN;
+  s->framebuffer = SY_GL_STATE_UNKNOWN;
+  s->renderState = SY_GL_STATE_UNKNOWN;
+  s->viewportWidth = s->viewportHeight = -1;
+  for (size_t i = 0; i < SY_GL_STATE_TEXTURE_UNITS; i++) {
+    s->textures[i] = SY_GL_STATE_UNKNOWN;
+  }
+}
+
+// Creates the uniform tables and forgets all bindings.
+static inline void syGlStateInit(syGlState *s) {
+  memset(s, 0, sizeof(*s));
+  syGlStateInvalidate(s);
+  s->uniformTables =
+      (syUniformTable *)calloc(SY_MAX_SHADER_PROGRAMS, sizeof(syUniformTable));
+}
+
+static inline void syGlStateDestroy(syGlState *s) {
+  for (size_t i = 0; s->uniformTables != NULL && i < SY_MAX_SHADER_PROGRAMS;
+       i++) {
+    syUniformTable *t = &s->uniformTables[i];
+    for (size_t j = 0; j < t->len; j++) {
+      free(t->uniforms[j].name);
+    }
+    free(t->uniforms);
+  }
+  free(s->uniformTables);
+  s->uniformTables = NULL;
+  if (syGlCurrentState == s) {
+    syGlCurrentState = NULL;
+  }
+}
+
+// Replaces the contents of `buffer` with `size` bytes of `data`, which are
+// counted in `s->stats.bytesUploaded` unless `s` is `NULL`.
+static inline void syWriteBuffer(syGlState *s, GLenum target, GLuint buffer,
+                                 GLsizeiptr size, const void *data,
+                                 GLenum usage) {
   glBindBuffer(target, buffer);
   glBufferData(target, size, data, usage);
+  if (s != NULL && data != NULL) {
+    s->stats.bytesUploaded += (uint64_t)size;
+  }
 }
 
-static inline void syWriteArrayBuffer(GLuint buffer, size_t size, void *data) {
-  syWriteBuffer(GL_ARRAY_BUFFER, buffer, (GLsizeiptr)size, data,
+static inline void syWriteArrayBuffer(syGlState *s, GLuint buffer, size_t size,
+                                      void *data) {
+  syWriteBuffer(s, GL_ARRAY_BUFFER, buffer, (GLsizeiptr)size, data,
                 GL_DYNAMIC_DRAW);
 }
 
+static inline void syGlUseProgram(syGlState *s, GLuint program) {
+  if (s->program == program) {
+    s->elided++;
+    return;
+  }
+  glUseProgram(program);
+  s->program = program;
+  s->stats.programSwitches++;
+}
+
+static inline void syGlBindVertexArray(syGlState *s, GLuint vertexArray) {
+  if (s->vertexArray == vertexArray) {
+    s->elided++;
+    return;
+  }
+  glBindVertexArray(vertexArray);
+  s->vertexArray = vertexArray;
+  // The element array binding is part of the vertex array's state
+  s->elementArrayBuffer = SY_GL_STATE_UNKNOWN;
+}
+
+// Binds `buffer` to `target`. Only `GL_ARRAY_BUFFER` and
+// `GL_ELEMENT_ARRAY_BUFFER` bindings are tracked.
+static inline void syGlBindBuffer(syGlState *s, GLenum target, GLuint buffer) {
+  GLuint *bound = target == GL_ARRAY_BUFFER           ? &s->arrayBuffer
+                  : target == GL_ELEMENT_ARRAY_BUFFER ? &s->elementArrayBuffer
+                                                      : NULL;
+  if (bound != NULL && *bound == buffer) {
+    s->elided++;
+    return;
+  }
+  glBindBuffer(target, buffer);
+  if (bound != NULL) {
+    *bound = buffer;
+  }
+}
+
+// Binds the 2D `texture` to texture `unit`. The active texture unit is changed
+// whenever a bind is made.
+static inline void syGlBindTexture(syGlState *s, GLuint unit, GLuint texture) {
+  if (unit < SY_GL_STATE_TEXTURE_UNITS && s->textures[unit] == texture) {
+    s->elided++;
+    return;
+  }
+  glActiveTexture(GL_TEXTURE0 + unit);
+  glBindTexture(GL_TEXTURE_2D, texture);
+  if (unit < SY_GL_STATE_TEXTURE_UNITS) {
+    s->textures[unit] = texture;
+  }
+}
+
+static inline void syGlBindFramebuffer(syGlState *s, GLuint framebuffer) {
+  if (s->framebuffer == framebuffer) {
+    s->elided++;
+    return;
+  }
+  glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+  s->framebuffer = framebuffer;
+  s->stats.framebufferBinds++;
+}
+
+// Sets the viewport to `width` by `height` pixels from the origin.
+static inline void syGlViewport(syGlState *s, GLsizei width, GLsizei height) {
+  if (s->viewportWidth == width && s->viewportHeight == height) {
+    s->elided++;
+    return;
+  }
+  glViewport(0, 0, width, height);
+  s->viewportWidth = width;
+  s->viewportHeight = height;
+}
+
+// Counts a draw call of `count` vertices or indices in `mode`, repeated for
+// `instances` instances.
+static inline void syGlCountDraw(syGlState *s, GLenum mode, uint64_t count,
+                                 uint64_t instances) {
+  s->stats.drawCalls++;
+  s->stats.vertices += count * instances;
+  s->stats.primitives += syPrimitiveCount(mode, count) * instances;
+}
+
+// Enables or disables depth testing and blending to match the
+// `SY_RENDER_STATE_*` bits of `state`.
+static inline void syGlSetRenderState(syGlState *s, uint32_t state) {
+  if (s->renderState == state) {
+    s->elided++;
+    return;
+  }
+  static const struct {
+    uint32_t bit;
+    GLenum cap;
+  } caps[] = {{SY_RENDER_STATE_DEPTH_TEST, GL_DEPTH_TEST},
+              {SY_RENDER_STATE_BLEND, GL_BLEND}};
+  for (size_t i = 0; i < sizeof(caps) / sizeof(caps[0]); i++) {
+    bool known = s->renderState != SY_GL_STATE_UNKNOWN;
+    if (known && (s->renderState & caps[i].bit) == (state & caps[i].bit)) {
+      continue;
+    }
+    if (state & caps[i].bit) {
+      glEnable(caps[i].cap);
+    } else {
+      glDisable(caps[i].cap);
+    }
+  }
+  s->renderState = state;
+}
+
 static inline void syVertexAttribute(GLuint index, GLint size, GLenum type,
                                      GLboolean normalized, GLsizei stride,
                                      const void *pointer) {
@@ -39,4 +306,166 @@ static inline void syVertexAttribute4f(GLuint index) {
   syVertexAttribute(index, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), NULL);
 }
 
+static inline void syVertexAttribute3fAt(GLuint index, GLintptr offset) {
+  syVertexAttribute(index, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float),
+                    (const void *)offset);
+}
+
+static inline void syVertexAttribute4fAt(GLuint index, GLintptr offset) {
+  syVertexAttribute(index, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float),
+                    (const void *)offset);
+}
+
+// Reads 4 normalized unsigned bytes per vertex, such as `syColor8` colors.
+static inline void syVertexAttribute4ub(GLuint index) {
+  syVertexAttribute(index, 4, GL_UNSIGNED_BYTE, GL_TRUE, 4, NULL);
+}
+
+static inline void syVertexAttribute4ubAt(GLuint index, GLintptr offset) {
+  syVertexAttribute(index, 4, GL_UNSIGNED_BYTE, GL_TRUE, 4,
+                    (const void *)offset);
+}
+
+// @returns the smallest index type that can address `numVertices` vertices:
+// `GL_UNSIGNED_SHORT` for up to 65536 vertices, else `GL_UNSIGNED_INT`.
+static inline GLenum syIndexType(size_t numVertices) {
+  return numVertices <= 65536 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+}
+
+static inline size_t syIndexSize(GLenum type) {
+  return type == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(uint32_t);
+}
+
+// Copies `n` indices that fit in 16 bits into `out`.
+static inline void syNarrowIndices(const uint32_t *indices, uint16_t *out,
+                                   size_t n) {
+  for (size_t i = 0; i < n; i++) {
+    out[i] = (uint16_t)indices[i];
+  }
+}
+
+// Sets up the 4 consecutive attributes starting at `index` to read one `mat4`
+// per instance from `offset`.
+static inline void syVertexAttributeInstancedMat4fAt(GLuint index,
+                                                     GLintptr offset) {
+  for (GLuint i = 0; i < 4; i++) {
+    GLintptr column = offset + (GLintptr)(i * 4 * sizeof(float));
+    syVertexAttribute(index + i, 4, GL_FLOAT, GL_FALSE, 16 * sizeof(float),
+                      (const void *)column);
+    glVertexAttribDivisor(index + i, 1);
+  }
+}
+
+// Disables the vertex attribute array at `index` so that every vertex reads the
+// constant value `v` instead.
+static inline void syVertexAttributeConstant4f(GLuint index,
+                                               const float *const v) {
+  glDisableVertexAttribArray(index);
+  glVertexAttrib4fv(index, v);
+}
+
+// A buffer split into `SY_RING_BUFFER_SECTIONS` sections that are written to in
+// turn. A fence guards each section so that the CPU never overwrites data the
+// GPU has yet to read. When `glBufferStorage` is available, the buffer is
+// mapped once persistently and writes are plain copies into mapped memory.
+typedef struct syRingBuffer {
+  GLuint buffer;
+  uint8_t *data;
+  size_t sectionSize, offset;
+  int section;
+  GLsync fences[SY_RING_BUFFER_SECTIONS];
+} syRingBuffer;
+
+// Creates the ring buffer with `sectionSize` bytes per section. If
+// `bufferStorage` is `NULL`, sections are written to with unsynchronized
+// `glMapBufferRange` calls instead of a persistent mapping.
+static inline void syRingBufferInit(syRingBuffer *rb, size_t sectionSize,
+                                    syPFNGLBUFFERSTORAGEPROC bufferStorage) {
+  GLsizeiptr size = (GLsizeiptr)(sectionSize * SY_RING_BUFFER_SECTIONS);
+  rb->sectionSize = sectionSize;
+  rb->offset = 0;
+  rb->section = 0;
+  rb->data = NULL;
+  memset(rb->fences, 0, sizeof(rb->fences));
+  glGenBuffers(1, &rb->buffer);
+  glBindBuffer(GL_COPY_WRITE_BUFFER, rb->buffer);
+  if (bufferStorage != NULL) {
+    GLbitfield flags =
+        GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    bufferStorage(GL_COPY_WRITE_BUFFER, size, NULL, flags);
+    rb->data =
+        (uint8_t *)glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, size, flags);
+  } else {
+    glBufferData(GL_COPY_WRITE_BUFFER, size, NULL, GL_STREAM_DRAW);
+  }
+  glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+// Fences the current section and waits until the GPU is done with the next one.
+static inline void syRingBufferAdvance(syRingBuffer *rb) {
+  if (rb->fences[rb->section] != NULL) {
+    glDeleteSync(rb->fences[rb->section]);
+  }
+  rb->fences[rb->section] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  rb->section = (rb->section + 1) % SY_RING_BUFFER_SECTIONS;
+  rb->offset = 0;
+  GLsync fence = rb->fences[rb->section];
+  if (fence != NULL) {
+    GLenum status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+    while (status == GL_TIMEOUT_EXPIRED) {
+      status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+    }
+    glDeleteSync(fence);
+    rb->fences[rb->section] = NULL;
+  }
+}
+
+// Copies `size` bytes of `data` into the current section, advancing to the
+// next section if it is full.
+//
+// @returns the offset of the data within `rb->buffer`, or -1 if `size` exceeds
+// the size of a section.
+static inline GLintptr syRingBufferWrite(syRingBuffer *rb, const void *data,
+                                         size_t size) {
+  if (size > rb->sectionSize) {
+    return -1;
+  }
+  if (rb->offset + size > rb->sectionSize) {
+    syRingBufferAdvance(rb);
+  }
+  GLintptr offset =
+      (GLintptr)(rb->sectionSize * (size_t)rb->section + rb->offset);
+  if (rb->data != NULL) {
+    memcpy(rb->data + offset, data, size);
+  } else {
+    glBindBuffer(GL_COPY_WRITE_BUFFER, rb->buffer);
+    void *dst = glMapBufferRange(GL_COPY_WRITE_BUFFER, offset,
+                                 (GLsizeiptr)size,
+                                 GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT |
+                                     GL_MAP_INVALIDATE_RANGE_BIT);
+    memcpy(dst, data, size);
+    glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+  }
+  rb->offset += (size + SY_RING_BUFFER_ALIGNMENT - 1) &
+                ~(size_t)(SY_RING_BUFFER_ALIGNMENT - 1);
+  return offset;
+}
+
+static inline void syRingBufferDestroy(syRingBuffer *rb) {
+  for (int i = 0; i < SY_RING_BUFFER_SECTIONS; i++) {
+    if (rb->fences[i] != NULL) {
+      glDeleteSync(rb->fences[i]);
+      rb->fences[i] = NULL;
+    }
+  }
+  if (rb->data != NULL) {
+    glBindBuffer(GL_COPY_WRITE_BUFFER, rb->buffer);
+    glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    rb->data = NULL;
+  }
+  glDeleteBuffers(1, &rb->buffer);
+}
+
 #endif  // _SOYA_GL_H_
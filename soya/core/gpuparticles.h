@@ -0,0 +1,233 @@
+/**
+ * @file gpuparticles.h
+ *
+ * Particle system that is simulated in a compute shader and drawn straight
+ * from the buffers it is simulated in, without any CPU–GPU traffic per frame.
+ * */
+#ifndef _SOYA_GPUPARTICLES_H
+#define _SOYA_GPUPARTICLES_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <soya/lib/sl.h>
+#include <soya/core/gl.h>
+#include <soya/core/app.h>
+#include <soya/core/shader.h>
+#include <soya/glad/glad.h>
+
+#include <cglm/struct.h>
+
+// Shader storage binding points the particle buffers are bound to while
+// updating
+#define SY_GPU_PARTICLES_POSITIONS_BINDING 0
+#define SY_GPU_PARTICLES_VELOCITIES_BINDING 1
+#define SY_GPU_PARTICLES_AGES_BINDING 2
+#define SY_GPU_PARTICLES_WORK_GROUP_SIZE 256
+
+#define SY_GPU_PARTICLES_SSBO(binding, declaration)                  \
+  "layout (std430, binding = " SYSL_STRINGIFY(binding) ") buffer " \
+      declaration "\n"
+
+static const char *SY_GPU_PARTICLES_COMPUTE_SHADER =
+    "#version 430 core\n"
+    "layout (local_size_x = "
+    SYSL_STRINGIFY(SY_GPU_PARTICLES_WORK_GROUP_SIZE) ") in;\n"
+    SY_GPU_PARTICLES_SSBO(SY_GPU_PARTICLES_POSITIONS_BINDING,
+                          "Positions { vec4 positions[]; };")
+    SY_GPU_PARTICLES_SSBO(SY_GPU_PARTICLES_VELOCITIES_BINDING,
+                          "Velocities { vec4 velocities[]; };")
+    SY_GPU_PARTICLES_SSBO(SY_GPU_PARTICLES_AGES_BINDING,
+                          "Ages { vec2 ages[]; };")
+    "uniform int count;\n"
+    "uniform int seed;\n"
+    "uniform float dt;\n"
+    "uniform float time;\n"
+    "uniform vec3 spawnMin;\n"
+    "uniform vec3 spawnMax;\n"
+    "uniform float speed;\n"
+    "uniform float minLifetime;\n"
+    "uniform float maxLifetime;\n"
+    "uniform float noiseScale;\n"
+    "uniform float noiseStrength;\n"
+    "uint hash(uint x) {\n"
+    "  x ^= x >> 16; x *= 0x7feb352du;\n"
+    "  x ^= x >> 15; x *= 0x846ca68bu;\n"
+    "  return x ^ (x >> 16);\n"
+    "}\n"
+    "float random(inout uint state) {\n"
+    "  state = hash(state);\n"
+    "  return float(state) / 4294967295.0;\n"
+    "}\n"
+    "float valueHash(vec3 p) {\n"
+    "  p = fract(p * 0.3183099 + 0.1) * 17.0;\n"
+    "  return fract(p.x * p.y * p.z * (p.x + p.y + p.z));\n"
+    "}\n"
+    "float noise(vec3 x) {\n"
+    "  vec3 i = floor(x);\n"
+    "  vec3 f = fract(x);\n"
+    "  f = f * f * (3.0 - 2.0 * f);\n"
+    "  return mix(mix(mix(valueHash(i), valueHash(i + vec3(1, 0, 0)), f.x),\n"
+    "                 mix(valueHash(i + vec3(0, 1, 0)),\n"
+    "                     valueHash(i + vec3(1, 1, 0)), f.x), f.y),\n"
+    "             mix(mix(valueHash(i + vec3(0, 0, 1)),\n"
+    "                     valueHash(i + vec3(1, 0, 1)), f.x),\n"
+    "                 mix(valueHash(i + vec3(0, 1, 1)),\n"
+    "                     valueHash(i + vec3(1, 1, 1)), f.x), f.y), f.z);\n"
+    "}\n"
+    "void main() {\n"
+    "  uint i = gl_GlobalInvocationID.x;\n"
+    "  if (i >= uint(count)) return;\n"
+    "  vec3 pos = positions[i].xyz;\n"
+    "  vec3 vel = velocities[i].xyz;\n"
+    "  vec2 age = ages[i];\n"
+    // Axes along which the spawn box has no extent are left untouched
+    "  vec3 mask = vec3(notEqual(spawnMin, spawnMax));\n"
+    "  if (age.x >= age.y) {\n"
+    "    uint state = hash(i ^ hash(uint(seed)));\n"
+    "    pos = mix(spawnMin, spawnMax,\n"
+    "              vec3(random(state), random(state), random(state)));\n"
+    "    vec3 dir = vec3(random(state), random(state), random(state));\n"
+    "    vel = normalize((dir * 2.0 - 1.0) * mask + 1e-6) * speed;\n"
+    "    age = vec2(0.0, mix(minLifetime, maxLifetime, random(state)));\n"
+    "  }\n"
+    "  if (noiseStrength > 0.0) {\n"
+    "    vec3 p = pos * noiseScale + vec3(0.0, 0.0, time);\n"
+    "    vec3 flow = vec3(noise(p), noise(p + 31.41), noise(p - 17.13));\n"
+    "    flow = normalize((flow * 2.0 - 1.0) * mask + 1e-6) * speed;\n"
+    "    vel = mix(vel, flow, noiseStrength);\n"
+    "  }\n"
+    "  pos += vel * mask * dt;\n"
+    "  age.x += dt;\n"
+    "  positions[i] = vec4(pos, 1.0);\n"
+    "  velocities[i] = vec4(vel, 0.0);\n"
+    "  ages[i] = age;\n"
+    "}\n\0";
+
+/**
+ * Options of a `syGpuParticles` system. Lifetimes are in seconds and `speed`
+ * is in units per second.
+ * */
+typedef struct syGpuParticlesOptions {
+  size_t count;
+  // Particles respawn at a random point within this box. Axes along which the
+  // box has no extent are neither moved along nor affected by the flow field,
+  // so a box with `spawnMin.z == spawnMax.z` gives a 2D system.
+  vec3s spawnMin, spawnMax;
+  float speed;
+  float minLifetime, maxLifetime;
+  // Frequency of the noise flow field
+  float noiseScale;
+  // How much the flow field steers the particles, from 0 (off) to 1.
+  float noiseStrength;
+} syGpuParticlesOptions;
+
+/**
+ * Particles whose position, velocity and age are stored in shader storage
+ * buffers. @ref syGpuParticlesUpdate advances them in a compute shader and
+ * @ref syDrawGpuParticles draws them as points from the position buffer.
+ * */
+typedef struct syGpuParticles {
+  // vec4 positions, vec4 velocities and vec2 ages (age, lifetime)
+  GLuint positions, velocities, ages;
+  GLuint vao;
+  syShader compute;
+  uint32_t seed;
+  syGpuParticlesOptions options;
+} syGpuParticles;
+
+/**
+ * Creates the particle buffers. All particles are spawned on the first update.
+ * */
+static inline void syGpuParticlesCreate(syGpuParticles *p,
+                                        const syGpuParticlesOptions *options) {
+  p->options = *options;
+  p->seed = 0;
+  GLint prevVertexArray = 0, prevArrayBuffer = 0;
+  glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &prevVertexArray);
+  glGetIntegerv(GL_ARRAY_BUFFER_BINDING, &prevArrayBuffer);
+
+  GLuint *buffers[] = {&p->positions, &p->velocities, &p->ages};
+  size_t strides[] = {sizeof(float) * 4, sizeof(float) * 4, sizeof(float) * 2};
+  for (size_t i = 0; i < 3; i++) {
+    glGenBuffers(1, buffers[i]);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, *buffers[i]);
+    glBufferData(GL_SHADER_STORAGE_BUFFER,
+                 (GLsizeiptr)(strides[i] * options->count), NULL,
+                 GL_DYNAMIC_COPY);
+    // Zero ages and lifetimes make every particle respawn on the first update
+    glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32F, GL_RED, GL_FLOAT,
+                      NULL);
+  }
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+  glGenVertexArrays(1, &p->vao);
+  glBindVertexArray(p->vao);
+  glBindBuffer(GL_ARRAY_BUFFER, p->positions);
+  glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(float) * 4, (void *)0);
+  glEnableVertexAttribArray(0);
+  glBindVertexArray((GLuint)prevVertexArray);
+  glBindBuffer(GL_ARRAY_BUFFER, (GLuint)prevArrayBuffer);
+
+  p->compute =
+      syShaderComputeProgramLoadFromSource(SY_GPU_PARTICLES_COMPUTE_SHADER);
+}
+
+/**
+ * Advances the particles by `dt` seconds.
+ * */
+static inline void syGpuParticlesUpdate(syApp *app, syGpuParticles *p,
+                                        float dt) {
+  syRendererFlush(&app->renderer);
+  const syGpuParticlesOptions *o = &p->options;
+  syShader s = p->compute;
+  syGlState *gl = &app->renderer.gl;
+  syGlUseProgram(gl, s);
+  syGlUniform1i(gl, s, "count", (int)o->count);
+  syGlUniform1i(gl, s, "seed", (int)p->seed++);
+  syGlUniform1f(gl, s, "dt", dt);
+  syGlUniform1f(gl, s, "time", (float)app->time);
+  syGlUniform3fv(gl, s, "spawnMin", (float *)&o->spawnMin);
+  syGlUniform3fv(gl, s, "spawnMax", (float *)&o->spawnMax);
+  syGlUniform1f(gl, s, "speed", o->speed);
+  syGlUniform1f(gl, s, "minLifetime", o->minLifetime);
+  syGlUniform1f(gl, s, "maxLifetime", o->maxLifetime);
+  syGlUniform1f(gl, s, "noiseScale", o->noiseScale);
+  syGlUniform1f(gl, s, "noiseStrength", o->noiseStrength);
+  GLenum target = GL_SHADER_STORAGE_BUFFER;
+  glBindBufferBase(target, SY_GPU_PARTICLES_POSITIONS_BINDING, p->positions);
+  glBindBufferBase(target, SY_GPU_PARTICLES_VELOCITIES_BINDING, p->velocities);
+  glBindBufferBase(target, SY_GPU_PARTICLES_AGES_BINDING, p->ages);
+  GLuint numGroups =
+      (GLuint)((o->count + SY_GPU_PARTICLES_WORK_GROUP_SIZE - 1) /
+               SY_GPU_PARTICLES_WORK_GROUP_SIZE);
+  glDispatchCompute(numGroups, 1, 1);
+  // Make the new positions visible to vertex fetches and the next update
+  glMemoryBarrier(GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT |
+                  GL_SHADER_STORAGE_BARRIER_BIT);
+  syGlUseProgram(&app->renderer.gl, app->renderer.shader);
+}
+
+/**
+ * Draws the particles as points in the current color with the current shader
+ * and transformations.
+ * */
+static inline void syDrawGpuParticles(syApp *app, const syGpuParticles *p) {
+  syRendererFlush(&app->renderer);
+  syRenderer *r = &app->renderer;
+  syGlBindVertexArray(&r->gl, p->vao);
+  syVertexAttributeConstant4f(1, r->color);
+  syRendererSetShaderUniforms(r, r->shader);
+  glDrawArrays(GL_POINTS, 0, (GLsizei)p->options.count);
+  syGlCountDraw(&r->gl, GL_POINTS, p->options.count, 1);
+}
+
+static inline void syGpuParticlesDestroy(syGpuParticles *p) {
+  syShaderDestroy(p->compute);
+  glDeleteVertexArrays(1, &p->vao);
+  glDeleteBuffers(1, &p->positions);
+  glDeleteBuffers(1, &p->velocities);
+  glDeleteBuffers(1, &p->ages);
+}
+
+#endif  // _SOYA_GPUPARTICLES_H
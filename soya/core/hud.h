@@ -0,0 +1,222 @@
+/**
+ * @file hud.h
+ *
+ * Performance overlay showing a frame-time graph, CPU and GPU times, renderer
+ * counters and memory usage, drawn with a built-in bitmap font. All of it is
+ * built into one vertex array that is drawn with a single draw call.
+ * */
+#ifndef _SOYA_HUD_H
+#define _SOYA_HUD_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#ifdef __linux__
+#include <unistd.h>
+#endif
+
+#include <soya/lib/vec.h>
+#include <soya/lib/color.h>
+#include <soya/lib/framestats.h>
+#include <soya/core/gl.h>
+#include <soya/core/profile.h>
+
+#include <GLFW/glfw3.h>
+
+#define SY_HUD_GLYPH_WIDTH 3
+#define SY_HUD_GLYPH_HEIGHT 5
+// Size of a font pixel in screen pixels
+#define SY_HUD_SCALE 2
+// Number of frames shown in the frame-time graph
+#define SY_HUD_GRAPH_FRAMES 120
+#define SY_HUD_DEFAULT_TOGGLE_KEY GLFW_KEY_F3
+#define SY_HUD_MEMORY_INTERVAL 30
+
+// 3x5 glyphs of the characters from ' ' to '_', 3 bits per row from the top
+// row in the most significant bits, with the left pixel in the highest bit of
+// each row. Lowercase letters are drawn as uppercase.
+static const uint16_t SY_HUD_FONT[64] = {
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x52A5, 0x0000, 0x0000,  //  !"#$%&'
+    0x1491, 0x4494, 0x0000, 0x05D0, 0x0014, 0x01C0, 0x0002, 0x12A4,  // ()*+,-./
+    0x7B6F, 0x2C97, 0x73E7, 0x73CF, 0x5BC9, 0x79CF, 0x79EF, 0x7249,  // 01234567
+    0x7BEF, 0x7BCF, 0x0410, 0x0000, 0x0000, 0x0E38, 0x0000, 0x0000,  // 89:;<=>?
+    0x0000, 0x2BED, 0x6BAE, 0x3923, 0x6B6E, 0x79A7, 0x79A4, 0x396B,  // @ABCDEFG
+    0x5BED, 0x7497, 0x126A, 0x5BAD, 0x4927, 0x5FED, 0x6B6D, 0x2B6A,  // HIJKLMNO
+    0x6BA4, 0x2B73, 0x6BAD, 0x388E, 0x7492, 0x5B6F, 0x5B6A, 0x5BFD,  // PQRSTUVW
+    0x5AAD, 0x5A92, 0x72A7, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,  // XYZ[ ]^_
+};
+
+/**
+ * State of the performance overlay. Toggled with `toggleKey`, or by setting
+ * `visible`.
+ * */
+typedef struct syHud {
+  bool visible;
+  // Default: SY_HUD_DEFAULT_TOGGLE_KEY (F3)
+  int toggleKey;
+  // Triangles of the overlay, rebuilt every frame
+  syVec(float) vertices;
+  syVec(float) colors;
+  // Resident memory in bytes, read every `SY_HUD_MEMORY_INTERVAL` frames
+  uint64_t memory;
+} syHud;
+
+static inline void syHudInit(syHud *h) {
+  h->visible = false;
+  h->toggleKey = SY_HUD_DEFAULT_TOGGLE_KEY;
+  h->memory = 0;
+  syVecInit(h->vertices, float);
+  syVecInit(h->colors, float);
+}
+
+static inline void syHudDestroy(syHud *h) {
+  syVecDestroy(h->vertices);
+  syVecDestroy(h->colors);
+}
+
+// Appends a rectangle with its bottom-left corner at (`x`, `y`).
+static inline void syHudRect(syHud *h, float x, float y, float w, float height,
+                             syColor color) {
+  float x1 = x + w, y1 = y + height;
+  float v[] = {x, y, 0, x1, y, 0, x1, y1, 0, x, y, 0, x1, y1, 0, x, y1, 0};
+  syVecPushArr(h->vertices, v, 18);
+  for (int i = 0; i < 6; i++) {
+    syVecPush4(h->colors, color.r, color.g, color.b, color.a);
+  }
+}
+
+/**
+ * Appends `text` with the top-left corner of its first line at (`x`, `y`).
+ * Consecutive pixels in a glyph row are merged into one rectangle.
+ * @returns the x coordinate after the last character.
+ * */
+static inline float syHudText(syHud *h, float x, float y, const char *text,
+                              syColor color) {
+  const float px = SY_HUD_SCALE;
+  for (const char *c = text; *c != '\0'; c++, x += px * 4) {
+    int code = *c >= 'a' && *c <= 'z' ? *c - 'a' + 'A' : *c;
+    if (code < ' ' || code > '_') {
+      continue;
+    }
+    uint16_t glyph = SY_HUD_FONT[code - ' '];
+    for (int row = 0; row < SY_HUD_GLYPH_HEIGHT; row++) {
+      int bits = (glyph >> ((SY_HUD_GLYPH_HEIGHT - 1 - row) * 3)) & 0x7;
+      for (int col = 0; col < SY_HUD_GLYPH_WIDTH;) {
+        if (!(bits & (4 >> col))) {
+          col++;
+          continue;
+        }
+        int run = col;
+        while (run < SY_HUD_GLYPH_WIDTH && (bits & (4 >> run))) {
+          run++;
+        }
+        syHudRect(h, x + (float)col * px, y - (float)(row + 1) * px,
+                  (float)(run - col) * px, px, color);
+        col = run;
+      }
+    }
+  }
+  return x;
+}
+
+// @returns the resident memory of the process in bytes, or 0 where it cannot
+// be read.
+static inline uint64_t syHudMemoryUsage(void) {
+#ifdef __linux__
+  FILE *f = fopen("/proc/self/statm", "r");
+  if (f == NULL) {
+    return 0;
+  }
+  unsigned long pages = 0, resident = 0;
+  int read = fscanf(f, "%lu %lu", &pages, &resident);
+  fclose(f);
+  long pageSize = sysconf(_SC_PAGESIZE);
+  if (read != 2 || pageSize <= 0) {
+    return 0;
+  }
+  return (uint64_t)resident * (uint64_t)pageSize;
+#else
+  return 0;
+#endif
+}
+
+/**
+ * Rebuilds the overlay's triangles in the top-left corner of a window `height`
+ * pixels high, with the origin at the bottom left. GPU times are only measured
+ * when profiling is compiled in. Otherwise the GPU line reads "GPU OFF" rather
+ * than hiding, so that the overlay keeps its layout, while "GPU -" means that
+ * no frame has been read back yet.
+ * */
+static inline void syHudBuild(syHud *h, const syFrameStats *frames,
+                              const syProfiler *profiler,
+                              const syRenderStats *stats, int height) {
+  h->vertices.len = 0;
+  h->colors.len = 0;
+  const float margin = 8, lineHeight = (SY_HUD_GLYPH_HEIGHT + 2) * SY_HUD_SCALE;
+  const float graphHeight = 60, barWidth = 2;
+  // Wide enough for 40 characters
+  const float panelWidth = 40 * 4 * SY_HUD_SCALE + margin * 2;
+  const int numLines = 5;
+  float top = (float)height - margin;
+  float panelHeight = graphHeight + lineHeight * numLines + margin * 3;
+  syHudRect(h, margin, top - panelHeight, panelWidth, panelHeight,
+            syRgb(0, 0, 0, 0.7f));
+
+  // Frame-time graph, 33 ms high, with a line at 16.7 ms
+  float x0 = margin * 2, y0 = top - margin - graphHeight;
+  float msHeight = graphHeight / 33.3f;
+  size_t n = frames->len < SY_HUD_GRAPH_FRAMES ? frames->len
+                                                : SY_HUD_GRAPH_FRAMES;
+  for (size_t i = 0; i < n; i++) {
+    size_t index = (frames->next + SY_FRAME_STATS_CAPACITY - n + i) %
+                   SY_FRAME_STATS_CAPACITY;
+    double ms = frames->frames[index].total * 1e3;
+    float barHeight = (float)(ms < 33.3 ? ms : 33.3) * msHeight;
+    syColor color = frames->hitches[index] ? syRgb(1, 0.3f, 0.3f, 1)
+                                           : syRgb(0.3f, 1, 0.5f, 1);
+    syHudRect(h, x0 + (float)i * barWidth, y0, barWidth, barHeight, color);
+  }
+  syHudRect(h, x0, y0 + 16.7f * msHeight, SY_HUD_GRAPH_FRAMES * barWidth, 1,
+            syRgb(1, 1, 1, 0.5f));
+
+  char line[96];
+  syColor white = syRgb(1, 1, 1, 1);
+  float y = y0 - margin;
+  const syFrameTimeSummary *t = &frames->total;
+  snprintf(line, sizeof(line), "FRAME %.1f MS P99 %.1f HITCHES %zu",
+           t->p50 * 1e3, t->p99 * 1e3, frames->recentHitches);
+  syHudText(h, x0, y, line, white);
+  y -= lineHeight;
+  snprintf(line, sizeof(line), "CPU LOOP %.2f SWAP %.2f POLL %.2f",
+           frames->loop.p50 * 1e3, frames->swap.p50 * 1e3,
+           frames->poll.p50 * 1e3);
+  syHudText(h, x0, y, line, white);
+  y -= lineHeight;
+  const syProfileEvent *loop = syProfilerFind(profiler, "loop");
+  if (loop != NULL) {
+    snprintf(line, sizeof(line), "GPU LOOP %.2f MS",
+             (loop->gpuEnd - loop->gpuBegin) * 1e3);
+  } else {
+    snprintf(line, sizeof(line), SY_PROFILE_ENABLED ? "GPU -" : "GPU OFF");
+  }
+  syHudText(h, x0, y, line, white);
+  y -= lineHeight;
+  snprintf(line, sizeof(line), "DRAWS %llu PRIMS %llu UPLOAD %.1f KB",
+           (unsigned long long)stats->drawCalls,
+           (unsigned long long)stats->primitives,
+           (double)stats->bytesUploaded / 1024);
+  syHudText(h, x0, y, line, white);
+  y -= lineHeight;
+  if (frames->numFrames % SY_HUD_MEMORY_INTERVAL == 0 || h->memory == 0) {
+    h->memory = syHudMemoryUsage();
+  }
+  if (h->memory > 0) {
+    snprintf(line, sizeof(line), "MEM %.1f MB",
+             (double)h->memory / (1024 * 1024));
+  } else {
+    snprintf(line, sizeof(line), "MEM -");
+  }
+  syHudText(h, x0, y, line, white);
+}
+
+#endif  // _SOYA_HUD_H
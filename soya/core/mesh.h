@@ -0,0 +1,300 @@
+/**
+ * @file mesh.h
+ *
+ * Retained meshes whose geometry is uploaded once and drawn many times.
+ * */
+#ifndef _SOYA_MESH_H
+#define _SOYA_MESH_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdbool.h>
+
+#include <soya/lib/vec.h>
+#include <soya/lib/color.h>
+#include <soya/core/gl.h>
+#include <soya/core/frustum.h>
+#include <soya/glad/glad.h>
+
+/**
+ * Geometry stored in static GPU buffers with its own vertex array. Positions
+ * are bound to attribute 0 and colors, if any, to attribute 1. Meshes without
+ * colors are drawn in the current color.
+ *
+ * @sa syMeshCreate, syDrawMesh, syMeshDestroy
+ * */
+typedef struct syMesh {
+  GLuint vao, vbo, cbo, ibo;
+  GLenum mode;
+  size_t numVertices, numIndices;
+  // `GL_UNSIGNED_SHORT` or `GL_UNSIGNED_INT`
+  GLenum indexType;
+  bool hasColors;
+  // Bounding box of the positions, used for frustum culling
+  syAabb bounds;
+} syMesh;
+
+/**
+ * Uploads the geometry into a new mesh. `positions` holds 3 floats per vertex
+ * and `colors` one color per vertex, either 4 floats if `colorType` is
+ * `GL_FLOAT` or a `syColor8` if it is `GL_UNSIGNED_BYTE`. `colors` may be
+ * `NULL`. If `indices` is `NULL` or `numIndices` is 0, the mesh is drawn
+ * unindexed. Indices are stored in 16 bits when the vertex count allows. The
+ * uploaded bytes are counted in the stats of `s`, which may be `NULL`. The
+ * vertex array and array buffer bindings are restored afterwards.
+ * */
+static inline void syMeshCreateWithColorType(
+    syGlState *s, syMesh *m, const float *positions, const void *colors,
+    GLenum colorType, size_t numVertices, const uint32_t *indices,
+    size_t numIndices, GLenum mode) {
+  *m = (syMesh){.mode = mode,
+                .numVertices = numVertices,
+                .numIndices = indices == NULL ? 0 : numIndices,
+                .indexType = syIndexType(numVertices),
+                .hasColors = colors != NULL,
+                .bounds = syAabbFromPoints(positions, numVertices)};
+  GLint prevVertexArray = 0, prevArrayBuffer = 0;
+  glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &prevVertexArray);
+  glGetIntegerv(GL_ARRAY_BUFFER_BINDING, &prevArrayBuffer);
+  glGenVertexArrays(1, &m->vao);
+  glBindVertexArray(m->vao);
+
+  glGenBuffers(1, &m->vbo);
+  syWriteBuffer(s, GL_ARRAY_BUFFER, m->vbo,
+                (GLsizeiptr)(sizeof(float) * numVertices * 3), positions,
+                GL_STATIC_DRAW);
+  syVertexAttribute3f(0);
+
+  if (m->hasColors) {
+    bool packed = colorType == GL_UNSIGNED_BYTE;
+    size_t colorSize = packed ? sizeof(syColor8) : sizeof(float) * 4;
+    glGenBuffers(1, &m->cbo);
+    syWriteBuffer(s, GL_ARRAY_BUFFER, m->cbo,
+                  (GLsizeiptr)(colorSize * numVertices), colors,
+                  GL_STATIC_DRAW);
+    if (packed) {
+      syVertexAttribute4ub(1);
+    } else {
+      syVertexAttribute4f(1);
+    }
+  }
+
+  if (m->numIndices > 0) {
+    uint16_t *narrow = NULL;
+    const void *data = indices;
+    if (m->indexType == GL_UNSIGNED_SHORT) {
+      narrow = (uint16_t *)malloc(sizeof(uint16_t) * m->numIndices);
+      syNarrowIndices(indices, narrow, m->numIndices);
+      data = narrow;
+    }
+    glGenBuffers(1, &m->ibo);
+    syWriteBuffer(s, GL_ELEMENT_ARRAY_BUFFER, m->ibo,
+                  (GLsizeiptr)(syIndexSize(m->indexType) * m->numIndices),
+                  data, GL_STATIC_DRAW);
+    free(narrow);
+  }
+  glBindVertexArray((GLuint)prevVertexArray);
+  glBindBuffer(GL_ARRAY_BUFFER, (GLuint)prevArrayBuffer);
+}
+
+/**
+ * Uploads the geometry into a new mesh. `positions` holds 3 floats and `colors`
+ * 4 floats per vertex. @see syMeshCreateWithColorType
+ * */
+static inline void syMeshCreate(syGlState *s, syMesh *m,
+                                const float *positions, const float *colors,
+                                size_t numVertices, const uint32_t *indices,
+                                size_t numIndices, GLenum mode) {
+  syMeshCreateWithColorType(s, m, positions, colors, GL_FLOAT, numVertices,
+                            indices, numIndices, mode);
+}
+
+/**
+ * Uploads the geometry into a new mesh with packed 8-bit colors, which take 4
+ * instead of 16 bytes per vertex. @see syMeshCreateWithColorType
+ * */
+static inline void syMeshCreatePacked(syGlState *s, syMesh *m,
+                                      const float *positions,
+                                      const syColor8 *colors,
+                                      size_t numVertices,
+                                      const uint32_t *indices,
+                                      size_t numIndices, GLenum mode) {
+  syMeshCreateWithColorType(s, m, positions, colors, GL_UNSIGNED_BYTE,
+                            numVertices, indices, numIndices, mode);
+}
+
+/**
+ * Creates a mesh from vectors declared with @ref syVec. `positions` may contain
+ * `vec3s` or 3 floats per vertex, and `colors` `syColor` or 4 floats per
+ * vertex. Empty `colors` or `indices` vectors are ignored.
+ * */
+#define syMeshCreateFromVecs(s, m, positions, colors, indices, mode)         \
+  syMeshCreate((s), (m), (const float *)(positions).data,                    \
+               (colors).len == 0 ? NULL : (const float *)(colors).data,      \
+               (positions).len * sizeof((positions).data[0]) /               \
+                   (3 * sizeof(float)),                                      \
+               (indices).len == 0 ? NULL : (const uint32_t *)(indices).data, \
+               (indices).len, (mode))
+
+/**
+ * Deletes the mesh's vertex array and buffers.
+ * */
+static inline void syMeshDestroy(syMesh *m) {
+  glDeleteVertexArrays(1, &m->vao);
+  glDeleteBuffers(1, &m->vbo);
+  if (m->hasColors) {
+    glDeleteBuffers(1, &m->cbo);
+  }
+  if (m->numIndices > 0) {
+    glDeleteBuffers(1, &m->ibo);
+  }
+  *m = (syMesh){0};
+}
+
+/**
+ * Location of a mesh within a @ref syMeshPool.
+ * */
+typedef struct syPooledMesh {
+  uint32_t firstIndex, numIndices;
+  int32_t baseVertex;
+  bool hasColors;
+  syAabb bounds;
+} syPooledMesh;
+
+/**
+ * Indexed triangle meshes packed into shared vertex and index buffers, so that
+ * any number of them can be drawn with a single multi-draw call. Geometry is
+ * collected on the CPU by @ref syMeshPoolAdd and uploaded the next time the
+ * pool is drawn.
+ *
+ * @sa syDrawPooledMesh
+ * */
+typedef struct syMeshPool {
+  GLuint vao, vbo, cbo, ibo;
+  syVec(float) positions;
+  syVec(float) colors;
+  syVec(uint32_t) indices;
+  syVec(syPooledMesh) meshes;
+  // Number of vertices and indices uploaded, and that the buffers have room for
+  size_t uploadedVertices, uploadedIndices;
+  size_t vertexCapacity, indexCapacity;
+} syMeshPool;
+
+static inline void syMeshPoolInit(syMeshPool *pool) {
+  *pool = (syMeshPool){0};
+  syVecInit(pool->positions, float);
+  syVecInit(pool->colors, float);
+  syVecInit(pool->indices, uint32_t);
+  syVecInit(pool->meshes, syPooledMesh);
+  glGenVertexArrays(1, &pool->vao);
+  glGenBuffers(1, &pool->vbo);
+  glGenBuffers(1, &pool->cbo);
+  glGenBuffers(1, &pool->ibo);
+}
+
+/**
+ * Adds a triangle mesh to the pool. `positions` holds 3 floats and `colors` 4
+ * floats per vertex. Meshes without colors are drawn in the current color. If
+ * `indices` is `NULL`, the vertices are drawn in order.
+ * @returns the handle of the mesh within the pool.
+ * */
+static inline uint32_t syMeshPoolAdd(syMeshPool *pool, const float *positions,
+                                     const float *colors, size_t numVertices,
+                                     const uint32_t *indices,
+                                     size_t numIndices) {
+  static const float white[4] = {1, 1, 1, 1};
+  syPooledMesh m = {
+      .firstIndex = (uint32_t)pool->indices.len,
+      .numIndices = (uint32_t)(indices == NULL ? numVertices : numIndices),
+      .baseVertex = (int32_t)(pool->positions.len / 3),
+      .hasColors = colors != NULL,
+      .bounds = syAabbFromPoints(positions, numVertices)};
+  syVecPushArr(pool->positions, positions, numVertices * 3);
+  for (size_t i = 0; i < numVertices; i++) {
+    syVecPushArr(pool->colors, colors == NULL ? white : &colors[i * 4], 4);
+  }
+  for (uint32_t i = 0; i < m.numIndices; i++) {
+    syVecPush(pool->indices, indices == NULL ? i : indices[i]);
+  }
+  syVecPush(pool->meshes, m);
+  return (uint32_t)(pool->meshes.len - 1);
+}
+
+// Writes elements `uploaded` to `len` of `data`, `size` bytes each, to
+// `buffer`, which has room for `capacity` elements. If they do not fit, the
+// buffer is reallocated with room for twice as many and all of `data` written.
+static inline void _syMeshPoolWrite(syGlState *s, GLenum target, GLuint buffer,
+                                    const void *data, size_t size,
+                                    size_t uploaded, size_t len,
+                                    size_t capacity) {
+  if (len > capacity) {
+    syWriteBuffer(s, target, buffer, (GLsizeiptr)(size * len * 2), NULL,
+                  GL_STATIC_DRAW);
+    uploaded = 0;
+  } else {
+    glBindBuffer(target, buffer);
+  }
+  size_t offset = size * uploaded;
+  glBufferSubData(target, (GLintptr)offset,
+                  (GLsizeiptr)(size * len - offset),
+                  (const uint8_t *)data + offset);
+  if (s != NULL) {
+    s->stats.bytesUploaded += size * len - offset;
+  }
+}
+
+/**
+ * Uploads the geometry of meshes added since the last upload, appending it to
+ * the pool's buffers. The buffers are only reallocated, and all geometry
+ * uploaded again, when they run out of room. The vertex array and array buffer
+ * bindings are restored afterwards.
+ * */
+static inline void syMeshPoolUpload(syGlState *s, syMeshPool *pool) {
+  size_t numVertices = pool->positions.len / 3;
+  size_t numIndices = pool->indices.len;
+  if (numVertices == pool->uploadedVertices &&
+      numIndices == pool->uploadedIndices) {
+    return;
+  }
+  GLint prevVertexArray = 0, prevArrayBuffer = 0;
+  glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &prevVertexArray);
+  glGetIntegerv(GL_ARRAY_BUFFER_BINDING, &prevArrayBuffer);
+  glBindVertexArray(pool->vao);
+  _syMeshPoolWrite(s, GL_ARRAY_BUFFER, pool->vbo, pool->positions.data,
+                   sizeof(float) * 3, pool->uploadedVertices, numVertices,
+                   pool->vertexCapacity);
+  syVertexAttribute3f(0);
+  _syMeshPoolWrite(s, GL_ARRAY_BUFFER, pool->cbo, pool->colors.data,
+                   sizeof(float) * 4, pool->uploadedVertices, numVertices,
+                   pool->vertexCapacity);
+  syVertexAttribute4f(1);
+  _syMeshPoolWrite(s, GL_ELEMENT_ARRAY_BUFFER, pool->ibo, pool->indices.data,
+                   sizeof(uint32_t), pool->uploadedIndices, numIndices,
+                   pool->indexCapacity);
+  if (numVertices > pool->vertexCapacity) {
+    pool->vertexCapacity = numVertices * 2;
+  }
+  if (numIndices > pool->indexCapacity) {
+    pool->indexCapacity = numIndices * 2;
+  }
+  pool->uploadedVertices = numVertices;
+  pool->uploadedIndices = numIndices;
+  glBindVertexArray((GLuint)prevVertexArray);
+  glBindBuffer(GL_ARRAY_BUFFER, (GLuint)prevArrayBuffer);
+}
+
+/**
+ * Deletes the pool's vertex array and buffers.
+ * */
+static inline void syMeshPoolDestroy(syMeshPool *pool) {
+  glDeleteVertexArrays(1, &pool->vao);
+  glDeleteBuffers(1, &pool->vbo);
+  glDeleteBuffers(1, &pool->cbo);
+  glDeleteBuffers(1, &pool->ibo);
+  syVecDestroy(pool->positions);
+  syVecDestroy(pool->colors);
+  syVecDestroy(pool->indices);
+  syVecDestroy(pool->meshes);
+}
+
+#endif  // _SOYA_MESH_H
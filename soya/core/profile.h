@@ -0,0 +1,284 @@
+/**
+ * @file profile.h
+ *
+ * Scoped CPU and GPU profiler. Each scope records CPU times and a pair of
+ * `GL_TIMESTAMP` queries, which are read back `SY_PROFILE_LATENCY` frames later
+ * so that the CPU never waits for the GPU. Timestamps are used instead of
+ * `GL_TIME_ELAPSED` queries because they can be nested.
+ *
+ * Profiling is compiled in when `SY_PROFILE` is defined, or in debug builds
+ * unless `SY_NO_PROFILE` is defined. Otherwise every function is empty and the
+ * profiler holds no scopes.
+ * */
+#ifndef _SOYA_PROFILE_H
+#define _SOYA_PROFILE_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include <soya/lib/vec.h>
+#include <soya/glad/glad.h>
+
+#include <GLFW/glfw3.h>
+
+#if defined(SY_PROFILE) || (defined(_DEBUG) && !defined(SY_NO_PROFILE))
+#define SY_PROFILE_ENABLED 1
+#else
+#define SY_PROFILE_ENABLED 0
+#endif
+
+// Maximum number of scopes per frame. Further scopes are ignored.
+#define SY_PROFILE_MAX_SCOPES 256
+#define SY_PROFILE_MAX_DEPTH 32
+// Number of frames after which GPU timestamps are read back
+#define SY_PROFILE_LATENCY 3
+
+/**
+ * A finished scope. Times are in seconds on the `glfwGetTime` clock, with GPU
+ * timestamps moved onto it.
+ * */
+typedef struct syProfileEvent {
+  // Must outlive the profiler, which string literals do
+  const char *name;
+  uint32_t depth;
+  uint64_t frame;
+  double cpuBegin, cpuEnd;
+  double gpuBegin, gpuEnd;
+} syProfileEvent;
+
+typedef struct syProfileScope {
+  const char *name;
+  uint32_t depth;
+  bool ended;
+  double cpuBegin, cpuEnd;
+} syProfileScope;
+
+// Scopes of a frame whose GPU timestamps have not been read yet
+typedef struct syProfileFrame {
+  syProfileScope scopes[SY_PROFILE_MAX_SCOPES];
+  // Begin and end timestamp query of each scope
+  GLuint queries[SY_PROFILE_MAX_SCOPES * 2];
+  size_t len;
+  uint64_t frame;
+} syProfileFrame;
+
+#if SY_PROFILE_ENABLED
+typedef struct syProfiler {
+  syProfileFrame frames[SY_PROFILE_LATENCY];
+  // Frame scopes are currently recorded into
+  syProfileFrame *current;
+  // Indices of the open scopes in `current`
+  size_t stack[SY_PROFILE_MAX_DEPTH];
+  size_t depth;
+  // Added to GPU timestamps to move them onto the CPU clock
+  double gpuOffset;
+  bool initialized;
+  // Scopes of the most recently read back frame
+  syProfileEvent last[SY_PROFILE_MAX_SCOPES];
+  size_t lastLen;
+  // Whether read back scopes are collected into `events` for a trace
+  bool capturing;
+  syVec(syProfileEvent) events;
+} syProfiler;
+#else
+// Placeholder with the fields used outside of this file, so that apps built
+// without profiling do not carry the scope buffers
+typedef struct syProfiler {
+  bool capturing;
+} syProfiler;
+#endif
+
+/**
+ * Creates the timestamp queries. Called by `main.h` once the GL context exists.
+ * */
+static inline void syProfilerInit(syProfiler *p) {
+  memset(p, 0, sizeof(*p));
+#if SY_PROFILE_ENABLED
+  for (size_t i = 0; i < SY_PROFILE_LATENCY; i++) {
+    glGenQueries(SY_PROFILE_MAX_SCOPES * 2, p->frames[i].queries);
+  }
+  GLint64 gpuNow = 0;
+  glGetInteger64v(GL_TIMESTAMP, &gpuNow);
+  p->gpuOffset = glfwGetTime() - (double)gpuNow * 1e-9;
+  syVecInit(p->events, syProfileEvent);
+  p->initialized = true;
+#endif
+}
+
+// Reads the GPU timestamps of `f`, waiting for them if they are not available
+// yet, and turns its scopes into events.
+static inline void syProfilerResolve(syProfiler *p, syProfileFrame *f) {
+#if SY_PROFILE_ENABLED
+  if (f->len == 0) {
+    return;
+  }
+  p->lastLen = 0;
+  for (size_t i = 0; i < f->len; i++) {
+    const syProfileScope *s = &f->scopes[i];
+    if (!s->ended) {
+      continue;
+    }
+    GLuint64 begin = 0, end = 0;
+    glGetQueryObjectui64v(f->queries[i * 2], GL_QUERY_RESULT, &begin);
+    glGetQueryObjectui64v(f->queries[i * 2 + 1], GL_QUERY_RESULT, &end);
+    syProfileEvent e = {.name = s->name,
+                        .depth = s->depth,
+                        .frame = f->frame,
+                        .cpuBegin = s->cpuBegin,
+                        .cpuEnd = s->cpuEnd,
+                        .gpuBegin = (double)begin * 1e-9 + p->gpuOffset,
+                        .gpuEnd = (double)end * 1e-9 + p->gpuOffset};
+    p->last[p->lastLen++] = e;
+    if (p->capturing) {
+      syVecPush(p->events, e);
+    }
+  }
+  f->len = 0;
+#else
+  (void)p;
+  (void)f;
+#endif
+}
+
+/**
+ * Starts recording the scopes of frame `frame`, reading back the frame that
+ * was recorded `SY_PROFILE_LATENCY` frames ago. Scopes left open are dropped.
+ * */
+static inline void syProfilerBeginFrame(syProfiler *p, uint64_t frame) {
+#if SY_PROFILE_ENABLED
+  if (!p->initialized) {
+    return;
+  }
+  syProfileFrame *f = &p->frames[frame % SY_PROFILE_LATENCY];
+  syProfilerResolve(p, f);
+  f->frame = frame;
+  p->current = f;
+  p->depth = 0;
+#else
+  (void)p;
+  (void)frame;
+#endif
+}
+
+static inline void syProfilerBegin(syProfiler *p, const char *name) {
+#if SY_PROFILE_ENABLED
+  syProfileFrame *f = p->current;
+  if (f == NULL || f->len == SY_PROFILE_MAX_SCOPES ||
+      p->depth == SY_PROFILE_MAX_DEPTH) {
+    return;
+  }
+  size_t i = f->len++;
+  f->scopes[i] = (syProfileScope){.name = name,
+                                  .depth = (uint32_t)p->depth,
+                                  .cpuBegin = glfwGetTime()};
+  glQueryCounter(f->queries[i * 2], GL_TIMESTAMP);
+  p->stack[p->depth++] = i;
+#else
+  (void)p;
+  (void)name;
+#endif
+}
+
+static inline void syProfilerEnd(syProfiler *p) {
+#if SY_PROFILE_ENABLED
+  if (p->current == NULL || p->depth == 0) {
+    return;
+  }
+  size_t i = p->stack[--p->depth];
+  syProfileScope *s = &p->current->scopes[i];
+  glQueryCounter(p->current->queries[i * 2 + 1], GL_TIMESTAMP);
+  s->cpuEnd = glfwGetTime();
+  s->ended = true;
+#else
+  (void)p;
+#endif
+}
+
+/**
+ * @returns the most recently read back scope called `name`, or `NULL`. Always
+ * `NULL` when profiling is compiled out.
+ * */
+static inline const syProfileEvent *syProfilerFind(const syProfiler *p,
+                                                   const char *name) {
+#if SY_PROFILE_ENABLED
+  for (size_t i = 0; i < p->lastLen; i++) {
+    if (strcmp(p->last[i].name, name) == 0) {
+      return &p->last[i];
+    }
+  }
+#else
+  (void)p;
+  (void)name;
+#endif
+  return NULL;
+}
+
+/**
+ * Writes the captured events to `path` as Chrome trace-event JSON, which can
+ * be opened in `chrome://tracing` or Perfetto, with CPU and GPU times on
+ * separate tracks. Frames not read back yet are read first, waiting for the
+ * GPU. The captured events are cleared.
+ * @returns `false` if the file could not be written.
+ * */
+static inline bool syProfilerWriteTrace(syProfiler *p, const char *path) {
+#if SY_PROFILE_ENABLED
+  if (!p->initialized) {
+    return false;
+  }
+  // Read back the remaining frames, oldest first
+  uint64_t frame = p->current != NULL ? p->current->frame : 0;
+  for (size_t i = 1; i <= SY_PROFILE_LATENCY; i++) {
+    syProfilerResolve(p, &p->frames[(frame + i) % SY_PROFILE_LATENCY]);
+  }
+  p->current = NULL;
+  FILE *f = fopen(path, "w");
+  if (f == NULL) {
+    fprintf(stderr, "%s(): Could not open %s\n", __func__, path);
+    return false;
+  }
+  fprintf(f, "{\"traceEvents\":[\n"
+             "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":0,"
+             "\"args\":{\"name\":\"CPU\"}},\n"
+             "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":1,"
+             "\"args\":{\"name\":\"GPU\"}}");
+  SY_VEC_FOREACH(p->events, i) {
+    const syProfileEvent *e = &p->events.data[i];
+    double begins[] = {e->cpuBegin, e->gpuBegin};
+    double ends[] = {e->cpuEnd, e->gpuEnd};
+    for (int tid = 0; tid < 2; tid++) {
+      fprintf(f,
+              ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":0,\"tid\":%i,"
+              "\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"frame\":%llu}}",
+              e->name, tid, begins[tid] * 1e6,
+              (ends[tid] - begins[tid]) * 1e6, (unsigned long long)e->frame);
+    }
+  }
+  fprintf(f, "\n]}\n");
+  fclose(f);
+  p->events.len = 0;
+  return true;
+#else
+  (void)p;
+  (void)path;
+  return false;
+#endif
+}
+
+static inline void syProfilerDestroy(syProfiler *p) {
+#if SY_PROFILE_ENABLED
+  if (!p->initialized) {
+    return;
+  }
+  for (size_t i = 0; i < SY_PROFILE_LATENCY; i++) {
+    glDeleteQueries(SY_PROFILE_MAX_SCOPES * 2, p->frames[i].queries);
+  }
+  syVecDestroy(p->events);
+  p->initialized = false;
+#else
+  (void)p;
+#endif
+}
+
+#endif  // _SOYA_PROFILE_H
@@ -1,24 +1,202 @@
 #ifndef _SOYA_RENDERER_H
 #define _SOYA_RENDERER_H
 
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include <soya/lib/sl.h>
+#include <soya/lib/vec.h>
+#include <soya/lib/color.h>
+#include <soya/core/gl.h>
+#include <soya/core/mesh.h>
+#include <soya/core/commands.h>
+#include <soya/core/frustum.h>
 #include <soya/core/shader.h>
+#include <soya/core/defaults.h>
 
 #include <cglm/struct.h>
 #include <soya/glad/glad.h>
+#include <GLFW/glfw3.h>
+
+// Vertex stream that collects small draws made with the default shader so that
+// they can be submitted with a single draw call. As long as every draw in the
+// batch uses the same renderer color, no per-vertex colors are stored and
+// `color` is submitted as a constant vertex attribute.
+typedef struct syBatch {
+  float *vertices, *colors;
+  size_t len, cap;
+  GLenum mode;
+  bool constantColor;
+  float color[4];
+  mat4s modelViewProjectionMatrix;
+  // `matrixVersion` of the renderer when the first vertex was collected
+  uint64_t matrixVersion;
+} syBatch;
+
+// Layout of the commands read by `glMultiDrawElementsIndirect`.
+typedef struct syDrawElementsIndirectCommand {
+  uint32_t count, instanceCount, firstIndex;
+  int32_t baseVertex;
+  uint32_t baseInstance;
+} syDrawElementsIndirectCommand;
+
+// Draws of meshes in the same `syMeshPool` collected for a single
+// `glMultiDrawElementsIndirect` call. Each command draws one instance whose
+// transform and color are read from `transforms` and `colors` at its
+// `baseInstance`.
+typedef struct syIndirectBatch {
+  syMeshPool *pool;
+  syVec(syDrawElementsIndirectCommand) commands;
+  syVec(mat4s) transforms;
+  syVec(syColor) colors;
+  mat4s modelViewProjectionMatrix;
+  uint64_t matrixVersion;
+} syIndirectBatch;
+
+// CPU side of the `syFrameUniforms` uniform block declared by
+// `SYSL_FRAME_UNIFORMS`, laid out according to std140.
+typedef struct syFrameUniforms {
+  mat4s view, projection, viewProjection;
+  float resolution[2];
+  float time;
+  uint32_t frameNum;
+} syFrameUniforms;
+
+typedef enum syPrimitive {
+  SY_PRIMITIVE_CUBE,
+  SY_PRIMITIVE_SPHERE,
+  SY_PRIMITIVE_POLYGON,
+  SY_PRIMITIVE_QUAD
+} syPrimitive;
+
+// Unit mesh of a built-in primitive. It is uploaded once and placed with a
+// model matrix when drawn. `detail` is the resolution or number of sides. A
+// copy of the vertices is kept for draws that are batched on the CPU.
+typedef struct syPrimitiveMesh {
+  syPrimitive primitive;
+  uint32_t detail;
+  syMesh mesh;
+  float *vertices;
+} syPrimitiveMesh;
 
 typedef struct syRenderer {
   GLuint vao, vbo, cbo, ibo;
+  // Per-instance transforms and colors of instanced draws
+  GLuint instanceVbo, instanceCbo;
   syShader shader;
   syShader defaultShader;
+  syShader instancedShader;
   mat4s modelMatrix, viewMatrix, projectionMatrix;
+  mat4s modelViewProjectionMatrix;
+  // Matrices `modelViewProjectionMatrix` was last computed from. Comparing
+  // against them also catches matrices that are assigned directly.
+  mat4s mvpModel, mvpView, mvpProjection;
+  // Whether `modelViewProjectionMatrix` has not been computed yet
+  bool matricesDirty;
+  // Incremented whenever `modelViewProjectionMatrix` is recomputed
+  uint64_t matrixVersion;
+  mat4s matrixStack[SY_MATRIX_STACK_DEPTH];
+  size_t matrixStackLen;
+  // Frustum of `modelViewProjectionMatrix` and the `matrixVersion` it was
+  // extracted at
+  syFrustum frustum;
+  uint64_t frustumVersion;
+  // Whether mesh, cube and sphere draws outside the frustum are skipped. Turn
+  // it off when a shader places vertices without `modelViewProjectionMatrix`.
+  // Default: true
+  bool culling;
+  // Number of draws skipped and made after being tested against the frustum
+  uint64_t numCulled, numSubmitted;
+  // Counters of the last complete frame. See `syRendererGetStats` for the
+  // current frame.
+  syRenderStats lastStats;
+  // Totals at the start of the frame that per-frame counts are taken from
+  syRenderStats statsBase;
   float color[4];
+  syBatch batch;
+  syIndirectBatch indirect;
+  // Buffer indirect commands are written to when they do not fit the stream
+  GLuint indirectBuffer;
+  // Ring buffer that all per-draw vertex and index data is streamed through.
+  syRingBuffer stream;
+  syVec(syPrimitiveMesh *) primitives;
+  // Scratch space for indices narrowed to 16 bits before uploading
+  syVec(uint16_t) narrowIndices;
+  syGlState gl;
+  // Current framebuffer, its size and `SY_RENDER_STATE_*` bits, recorded with
+  // commands. A `target` of 0 stands for `defaultFramebuffer`.
+  GLuint target;
+  GLsizei targetWidth, targetHeight;
+  uint32_t renderState;
+  // Whether draws are recorded into `commands` and sorted before they are
+  // executed at the end of the frame, instead of being executed immediately.
+  // Default: false
+  bool sorted;
+  // Whether recorded draws keep the order they were made in, for layered 2D
+  // drawing. Default: false
+  bool ordered;
+  syCommandBuffer commands;
+  // Framebuffer drawn into in place of the window's, such as the headless
+  // target, and its size. Default: 0 and the window's size
+  GLuint defaultFramebuffer;
+  GLsizei defaultWidth, defaultHeight;
+  // Command lists begun this frame, merged into `commands` in this order. The
+  // keys of the first `numMergedLists` are in `commands`, and the lists are
+  // dropped once their commands are executed.
+  syVec(syCommandList *) commandLists;
+  size_t numMergedLists;
+  // Uniform buffer holding the `syFrameUniforms` block, and the values last
+  // uploaded to it
+  GLuint frameUbo;
+  syFrameUniforms frameUniforms;
+  // Program drawing FBO textures with `syDrawFbo`, created when it is first
+  // needed and shared by all FBOs
+  syShader fboShader;
 } syRenderer;
 
+// @returns `glBufferStorage` if the current context supports it, else `NULL`.
+static inline syPFNGLBUFFERSTORAGEPROC syRendererLoadBufferStorage(void) {
+  GLint major = 0, minor = 0;
+  glGetIntegerv(GL_MAJOR_VERSION, &major);
+  glGetIntegerv(GL_MINOR_VERSION, &minor);
+  if (major * 10 + minor < 44 &&
+      !glfwExtensionSupported("GL_ARB_buffer_storage")) {
+    return NULL;
+  }
+  return (syPFNGLBUFFERSTORAGEPROC)glfwGetProcAddress("glBufferStorage");
+}
+
 static inline void syRendererInit(syRenderer *r, int width, int height) {
+  syGlStateInit(&r->gl);
+  syGlStateMakeCurrent(&r->gl);
+  r->lastStats = (syRenderStats){0};
+  r->statsBase = (syRenderStats){0};
+  r->target = 0;
+  r->defaultFramebuffer = 0;
+  r->defaultWidth = r->targetWidth = width;
+  r->defaultHeight = r->targetHeight = height;
+  r->renderState = SY_RENDER_STATE_DEPTH_TEST;
+  syGlSetRenderState(&r->gl, r->renderState);
+  glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+  r->sorted = false;
+  r->ordered = false;
+  syCommandBufferInit(&r->commands);
+  syVecInit(r->commandLists, syCommandList *);
+  r->numMergedLists = 0;
   glGenVertexArrays(1, &r->vao);
   glGenBuffers(1, &r->vbo);
   glGenBuffers(1, &r->cbo);
   glGenBuffers(1, &r->ibo);
+  glGenBuffers(1, &r->instanceVbo);
+  glGenBuffers(1, &r->instanceCbo);
+  glGenBuffers(1, &r->frameUbo);
+  glGenBuffers(1, &r->indirectBuffer);
+  glBindBuffer(GL_UNIFORM_BUFFER, r->frameUbo);
+  glBufferData(GL_UNIFORM_BUFFER, sizeof(syFrameUniforms), NULL,
+               GL_DYNAMIC_DRAW);
+  glBindBufferBase(GL_UNIFORM_BUFFER, SYSL_FRAME_UNIFORMS_BINDING,
+                   r->frameUbo);
   r->color[0] = 1;
   r->color[1] = 1;
   r->color[2] = 1;
@@ -27,16 +205,767 @@ static inline void syRendererInit(syRenderer *r, int width, int height) {
       glms_ortho(0, (float)width, 0, (float)height, 0.1f, 100.0);
   r->viewMatrix = glms_translate_make((vec3s){{0, 0, -1}});
   r->modelMatrix = glms_mat4_identity();
+  r->matricesDirty = true;
+  r->matrixVersion = 0;
+  r->matrixStackLen = 0;
+  r->frustumVersion = 0;
+  r->culling = true;
+  r->numCulled = 0;
+  r->numSubmitted = 0;
+  r->batch.len = 0;
+  r->batch.cap = SY_DEFAULT_BATCH_CAPACITY;
+  r->batch.vertices = (float *)calloc(r->batch.cap * 3, sizeof(float));
+  r->batch.colors = (float *)calloc(r->batch.cap * 4, sizeof(float));
+  r->indirect.pool = NULL;
+  syVecInit(r->indirect.commands, syDrawElementsIndirectCommand);
+  syVecInit(r->indirect.transforms, mat4s);
+  syVecInit(r->indirect.colors, syColor);
+  syPFNGLBUFFERSTORAGEPROC bufferStorage = syRendererLoadBufferStorage();
+  printf("%s(): Streaming vertex data through %s\n", __func__,
+         bufferStorage != NULL ? "persistently mapped buffers"
+                               : "unsynchronized buffer mappings");
+  syRingBufferInit(&r->stream, SY_DEFAULT_STREAM_BUFFER_SIZE, bufferStorage);
+  syVecInit(r->primitives, syPrimitiveMesh *);
+  syVecInit(r->narrowIndices, uint16_t);
   printf("%s(): Loading default shader\n", __func__);
   r->shader = syShaderProgramLoadDefault();
   r->defaultShader = r->shader;
-  glUseProgram(r->shader);
+  r->instancedShader = syShaderProgramLoadFromSource(
+      SY_DEFAULT_FRAGMENT_SHADER, SY_DEFAULT_INSTANCED_VERTEX_SHADER);
+  r->fboShader = 0;
+  syGlUseProgram(&r->gl, r->shader);
+}
+
+static inline void syRendererSetMatrixUniforms(syRenderer *r, syShader s,
+                                               mat4s projection, mat4s view,
+                                               mat4s model) {
+  mat4s mat = glms_mul(projection, glms_mul(view, model));
+  syGlUniformMat4fv(&r->gl, s, "modelViewProjectionMatrix", (float *)&mat);
 }
 
+static inline void syRendererSetModelMatrix(syRenderer *r, mat4s model) {
+  r->modelMatrix = model;
+}
+
+// @returns projection * view * model, recomputed only if one of the matrices
+// changed since the last call, whether through the setters or not.
+static inline const mat4s *syRendererGetModelViewProjection(syRenderer *r) {
+  if (r->matricesDirty ||
+      memcmp(&r->mvpModel, &r->modelMatrix, sizeof(mat4s)) != 0 ||
+      memcmp(&r->mvpView, &r->viewMatrix, sizeof(mat4s)) != 0 ||
+      memcmp(&r->mvpProjection, &r->projectionMatrix, sizeof(mat4s)) != 0) {
+    r->modelViewProjectionMatrix = glms_mul(
+        r->projectionMatrix, glms_mul(r->viewMatrix, r->modelMatrix));
+    r->mvpModel = r->modelMatrix;
+    r->mvpView = r->viewMatrix;
+    r->mvpProjection = r->projectionMatrix;
+    r->matricesDirty = false;
+    r->matrixVersion++;
+  }
+  return &r->modelViewProjectionMatrix;
+}
+
+// @returns the frustum of the current transformations, in model space.
+static inline const syFrustum *syRendererGetFrustum(syRenderer *r) {
+  syRendererGetModelViewProjection(r);
+  if (r->frustumVersion != r->matrixVersion) {
+    r->frustum = syFrustumFromMatrix(r->modelViewProjectionMatrix);
+    r->frustumVersion = r->matrixVersion;
+  }
+  return &r->frustum;
+}
+
+// @returns `true` if `box`, in model space, should be drawn. Always `true` if
+// culling is disabled.
+static inline bool syRendererCullAabb(syRenderer *r, const syAabb *box) {
+  if (!r->culling) {
+    return true;
+  }
+  bool visible = syFrustumTestAabb(syRendererGetFrustum(r), box);
+  r->numCulled += !visible;
+  r->numSubmitted += visible;
+  return visible;
+}
+
+// @returns `true` if the sphere, in model space, should be drawn. Always
+// `true` if culling is disabled.
+static inline bool syRendererCullSphere(syRenderer *r, vec3s center,
+                                        float radius) {
+  if (!r->culling) {
+    return true;
+  }
+  bool visible = syFrustumTestSphere(syRendererGetFrustum(r), center, radius);
+  r->numCulled += !visible;
+  r->numSubmitted += visible;
+  return visible;
+}
+
+// Sets the model view projection matrix of `s` to the renderer's. The uniform
+// is only uploaded if it differs from the last value sent to `s`.
 static inline void syRendererSetShaderUniforms(syRenderer *r, syShader s) {
-  mat4s mat =
-      glms_mul(r->projectionMatrix, (glms_mul(r->viewMatrix, r->modelMatrix)));
-  syShaderUniformMat4fv(s, "modelViewProjectionMatrix", (float *)&mat);
+  syGlUniformMat4fv(&r->gl, s, "modelViewProjectionMatrix",
+                    (float *)syRendererGetModelViewProjection(r));
+}
+
+// Uploads `u` to the uniform buffer bound to `SYSL_FRAME_UNIFORMS_BINDING`.
+static inline void syRendererSetFrameUniforms(syRenderer *r,
+                                              const syFrameUniforms *u) {
+  glBindBuffer(GL_UNIFORM_BUFFER, r->frameUbo);
+  glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(*u), u);
+  r->gl.stats.bytesUploaded += sizeof(*u);
+  r->frameUniforms = *u;
+}
+
+// Copies `size` bytes of `data` into the renderer's stream buffer and binds it
+// to `target`. Data too large for the stream buffer is written to `fallback`
+// instead.
+//
+// @returns the offset of the data within the buffer bound to `target`.
+static inline GLintptr syRendererUpload(syRenderer *r, GLenum target,
+                                        GLuint fallback, const void *data,
+                                        size_t size) {
+  r->gl.stats.bytesUploaded += size;
+  GLintptr offset = syRingBufferWrite(&r->stream, data, size);
+  if (offset >= 0) {
+    syGlBindBuffer(&r->gl, target, r->stream.buffer);
+    return offset;
+  }
+  syGlBindBuffer(&r->gl, target, fallback);
+  glBufferData(target, (GLsizeiptr)size, data, GL_DYNAMIC_DRAW);
+  return 0;
+}
+
+// Uploads `n` indices into `numVertices` vertices to the element array buffer,
+// narrowed to 16 bits when the vertex count allows.
+//
+// @returns the offset of the indices and their type in `type`.
+static inline GLintptr syRendererUploadIndices(syRenderer *r,
+                                               const uint32_t *indices,
+                                               size_t n, size_t numVertices,
+                                               GLenum *type) {
+  *type = syIndexType(numVertices);
+  const void *data = indices;
+  if (*type == GL_UNSIGNED_SHORT) {
+    syVecReserve(r->narrowIndices, n);
+    syNarrowIndices(indices, r->narrowIndices.data, n);
+    data = r->narrowIndices.data;
+  }
+  return syRendererUpload(r, GL_ELEMENT_ARRAY_BUFFER, r->ibo, data,
+                          syIndexSize(*type) * n);
+}
+
+// Sets attribute 1 of the bound vertex array to `n` colors, given as 4 floats
+// each if `type` is `GL_FLOAT` or as `syColor8` if it is `GL_UNSIGNED_BYTE`.
+// Without colors, every vertex uses `color`.
+static inline void syRendererSetColors(syRenderer *r, const void *colors,
+                                       GLenum type, size_t n,
+                                       const float *color) {
+  if (colors == NULL) {
+    syVertexAttributeConstant4f(1, color);
+  } else if (type == GL_UNSIGNED_BYTE) {
+    syVertexAttribute4ubAt(1, syRendererUpload(r, GL_ARRAY_BUFFER, r->cbo,
+                                               colors, sizeof(syColor8) * n));
+  } else {
+    syVertexAttribute4fAt(1, syRendererUpload(r, GL_ARRAY_BUFFER, r->cbo,
+                                              colors, sizeof(float) * n * 4));
+  }
+}
+
+// Records `c` with the current framebuffer and render state. The program is
+// left to the caller.
+static inline void syRendererRecord(syRenderer *r, syCommand *c) {
+  c->framebuffer = r->target;
+  c->width = r->targetWidth;
+  c->height = r->targetHeight;
+  c->renderState = r->renderState;
+  syCommandBufferPush(&r->commands, c, r->ordered);
+}
+
+// Binds the framebuffer `target`, where 0 stands for `defaultFramebuffer`, and
+// sets the viewport to its size of `width` by `height` pixels.
+static inline void syRendererBindTarget(syRenderer *r, GLuint target,
+                                        GLsizei width, GLsizei height) {
+  syGlBindFramebuffer(&r->gl, target == 0 ? r->defaultFramebuffer : target);
+  syGlViewport(&r->gl, width, height);
+}
+
+// @returns the buffer holding the commands of keys with `buffer`: 0 for
+// `commands`, otherwise the command list at `buffer - 1`.
+static inline const syCommandBuffer *syRendererCommandSource(
+    const syRenderer *r, uint32_t buffer) {
+  return buffer == 0 ? &r->commands : &r->commandLists.data[buffer - 1]->buffer;
+}
+
+// Draws `n` meshes of `pool` with `program` and one
+// `glMultiDrawElementsIndirect` call. Each draw command draws one instance,
+// whose transform and color are read from `transforms` and `colors`.
+static inline void syRendererDrawIndirect(
+    syRenderer *r, GLuint program, const syMeshPool *pool,
+    const syDrawElementsIndirectCommand *draws, const mat4s *transforms,
+    const syColor *colors, size_t n, const mat4s *mvp) {
+  syGlUseProgram(&r->gl, program);
+  syGlBindVertexArray(&r->gl, pool->vao);
+  syVertexAttribute4fAt(2, syRendererUpload(r, GL_ARRAY_BUFFER,
+                                            r->instanceCbo, colors,
+                                            sizeof(syColor) * n));
+  glVertexAttribDivisor(2, 1);
+  syVertexAttributeInstancedMat4fAt(
+      3, syRendererUpload(r, GL_ARRAY_BUFFER, r->instanceVbo, transforms,
+                          sizeof(mat4s) * n));
+  GLintptr offset = syRendererUpload(
+      r, GL_DRAW_INDIRECT_BUFFER, r->indirectBuffer, draws,
+      sizeof(syDrawElementsIndirectCommand) * n);
+  syGlUniformMat4fv(&r->gl, program, "modelViewProjectionMatrix",
+                    (float *)mvp);
+  glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT,
+                              (const void *)offset, (GLsizei)n, 0);
+  r->gl.stats.drawCalls++;
+  for (size_t i = 0; i < n; i++) {
+    r->gl.stats.vertices += (uint64_t)draws[i].count * draws[i].instanceCount;
+    r->gl.stats.primitives += draws[i].count / 3 * draws[i].instanceCount;
+  }
+}
+
+// Executes `c`, recorded into `cb`, binding the state it was recorded with.
+static inline void syRendererExecute(syRenderer *r, const syCommandBuffer *cb,
+                                     const syCommand *c) {
+  syRendererBindTarget(r, c->framebuffer, c->width, c->height);
+  syGlSetRenderState(&r->gl, c->renderState);
+  syGlUseProgram(&r->gl, c->program);
+  syGlUniformMat4fv(&r->gl, c->program, "modelViewProjectionMatrix",
+                    (float *)&c->modelViewProjectionMatrix);
+  if (c->type == SY_COMMAND_MESH) {
+    const syMesh *m = &c->mesh;
+    syGlBindVertexArray(&r->gl, m->vao);
+    if (!m->hasColors) {
+      syVertexAttributeConstant4f(1, c->color);
+    }
+    if (m->numIndices > 0) {
+      glDrawElements(m->mode, (GLsizei)m->numIndices, m->indexType, 0);
+      syGlCountDraw(&r->gl, m->mode, m->numIndices, 1);
+    } else {
+      glDrawArrays(m->mode, 0, (GLsizei)m->numVertices);
+      syGlCountDraw(&r->gl, m->mode, m->numVertices, 1);
+    }
+    return;
+  }
+  if (c->type == SY_COMMAND_POOL) {
+    syRendererDrawIndirect(
+        r, c->program, c->pool,
+        (const syDrawElementsIndirectCommand *)syCommandBufferData(cb,
+                                                                   c->draws),
+        (const mat4s *)syCommandBufferData(cb, c->transforms),
+        (const syColor *)syCommandBufferData(cb, c->colors), c->numDraws,
+        &c->modelViewProjectionMatrix);
+    return;
+  }
+  syGlBindVertexArray(&r->gl, r->vao);
+  syVertexAttribute3fAt(
+      0, syRendererUpload(r, GL_ARRAY_BUFFER, r->vbo,
+                          syCommandBufferData(cb, c->vertices),
+                          sizeof(float) * c->numVertices * 3));
+  syRendererSetColors(r, syCommandBufferData(cb, c->colors), GL_FLOAT,
+                      c->numVertices, c->color);
+  if (c->indices == SY_COMMAND_NO_DATA) {
+    glDrawArrays(c->mode, 0, (GLsizei)c->numVertices);
+    syGlCountDraw(&r->gl, c->mode, c->numVertices, 1);
+    return;
+  }
+  GLenum type;
+  GLintptr offset = syRendererUploadIndices(
+      r, (const uint32_t *)syCommandBufferData(cb, c->indices),
+      c->numIndices, c->numVertices, &type);
+  glDrawElements(c->mode, (GLsizei)c->numIndices, type, (const void *)offset);
+  syGlCountDraw(&r->gl, c->mode, c->numIndices, 1);
+}
+
+// Binds the current framebuffer, render state and program again after
+// executing commands.
+static inline void syRendererRestoreState(syRenderer *r) {
+  syRendererBindTarget(r, r->target, r->targetWidth, r->targetHeight);
+  syGlSetRenderState(&r->gl, r->renderState);
+  syGlUseProgram(&r->gl, r->shader);
+}
+
+// Drops the merged command lists, whose commands have been executed, and keeps
+// the ones that are still being recorded. Their passes were executed too, so
+// they are moved to the first pass of the cleared command buffer.
+static inline void syRendererReleaseCommandLists(syRenderer *r) {
+  size_t n = r->numMergedLists;
+  memmove(r->commandLists.data, r->commandLists.data + n,
+          sizeof(syCommandList *) * (r->commandLists.len - n));
+  r->commandLists.len -= n;
+  r->numMergedLists = 0;
+  SY_VEC_FOREACH(r->commandLists, i) {
+    r->commandLists.data[i]->pass = syCommandBufferReservePass(&r->commands);
+  }
+}
+
+// Sorts and executes all recorded commands, including those of merged command
+// lists, then restores the current framebuffer, render state and program.
+static inline void syRendererSubmitCommands(syRenderer *r) {
+  syCommandBuffer *cb = &r->commands;
+  if (cb->keys.len == 0) {
+    return;
+  }
+  const syCommandKey *keys = syCommandBufferSort(cb);
+  for (size_t i = 0; i < cb->keys.len; i++) {
+    const syCommandBuffer *src = syRendererCommandSource(r, keys[i].buffer);
+    syRendererExecute(r, src, &src->commands.data[keys[i].index]);
+  }
+  syCommandBufferClear(cb);
+  syRendererReleaseCommandLists(r);
+  syRendererRestoreState(r);
+}
+
+// Submits all vertices collected in the batch with one draw call.
+static inline void syRendererFlushBatch(syRenderer *r) {
+  syBatch *b = &r->batch;
+  if (b->len == 0) {
+    return;
+  }
+  if (r->sorted) {
+    syCommandBuffer *cb = &r->commands;
+    syCommand c = {
+        .type = SY_COMMAND_STREAM,
+        .mode = b->mode,
+        .program = r->defaultShader,
+        .vertices = syCommandBufferPushData(cb, b->vertices,
+                                            sizeof(float) * b->len * 3),
+        .colors = b->constantColor
+                      ? SY_COMMAND_NO_DATA
+                      : syCommandBufferPushData(cb, b->colors,
+                                                sizeof(float) * b->len * 4),
+        .indices = SY_COMMAND_NO_DATA,
+        .numVertices = (uint32_t)b->len,
+        .modelViewProjectionMatrix = b->modelViewProjectionMatrix};
+    memcpy(c.color, b->color, sizeof(b->color));
+    syRendererRecord(r, &c);
+    b->len = 0;
+    return;
+  }
+  syGlUseProgram(&r->gl, r->defaultShader);
+  syGlBindVertexArray(&r->gl, r->vao);
+  syVertexAttribute3fAt(0, syRendererUpload(r, GL_ARRAY_BUFFER, r->vbo,
+                                            b->vertices,
+                                            sizeof(float) * b->len * 3));
+  if (b->constantColor) {
+    syVertexAttributeConstant4f(1, b->color);
+  } else {
+    syVertexAttribute4fAt(1, syRendererUpload(r, GL_ARRAY_BUFFER, r->cbo,
+                                              b->colors,
+                                              sizeof(float) * b->len * 4));
+  }
+  syGlUniformMat4fv(&r->gl, r->defaultShader, "modelViewProjectionMatrix",
+                    (float *)&b->modelViewProjectionMatrix);
+  glDrawArrays(b->mode, 0, (GLsizei)b->len);
+  syGlCountDraw(&r->gl, b->mode, b->len, 1);
+  b->len = 0;
+}
+
+// Submits all pooled mesh draws collected in the indirect batch with one
+// `glMultiDrawElementsIndirect` call, using the instancing counterpart of the
+// current shader. While commands are sorted, the call is recorded instead.
+static inline void syRendererFlushIndirect(syRenderer *r) {
+  syIndirectBatch *b = &r->indirect;
+  if (b->commands.len == 0) {
+    return;
+  }
+  syShader shader =
+      r->shader == r->defaultShader ? r->instancedShader : r->shader;
+  size_t n = b->commands.len;
+  if (r->sorted) {
+    syCommandBuffer *cb = &r->commands;
+    syCommand c = {
+        .type = SY_COMMAND_POOL,
+        .program = shader,
+        .pool = b->pool,
+        .draws = syCommandBufferPushData(
+            cb, b->commands.data, sizeof(syDrawElementsIndirectCommand) * n),
+        .transforms = syCommandBufferPushData(cb, b->transforms.data,
+                                              sizeof(mat4s) * n),
+        .colors = syCommandBufferPushData(cb, b->colors.data,
+                                          sizeof(syColor) * n),
+        .vertices = SY_COMMAND_NO_DATA,
+        .indices = SY_COMMAND_NO_DATA,
+        .numDraws = (uint32_t)n,
+        .modelViewProjectionMatrix = b->modelViewProjectionMatrix};
+    syRendererRecord(r, &c);
+  } else {
+    syRendererDrawIndirect(r, shader, b->pool, b->commands.data,
+                           b->transforms.data, b->colors.data, n,
+                           &b->modelViewProjectionMatrix);
+    syGlUseProgram(&r->gl, r->shader);
+  }
+  b->commands.len = 0;
+  b->transforms.len = 0;
+  b->colors.len = 0;
+}
+
+// Submits the vertex and indirect batches. While commands are sorted, the
+// vertex batch is recorded instead.
+static inline void syRendererFlushBatches(syRenderer *r) {
+  syRendererFlushBatch(r);
+  syRendererFlushIndirect(r);
+}
+
+// Uploads the view and projection matrices to the frame uniforms if they differ
+// from the ones last uploaded, after submitting the batches drawn with the old
+// ones. Recorded commands read the frame uniforms when they are executed.
+static inline void syRendererUpdateFrameMatrices(syRenderer *r) {
+  syFrameUniforms *u = &r->frameUniforms;
+  if (memcmp(&u->view, &r->viewMatrix, sizeof(mat4s)) == 0 &&
+      memcmp(&u->projection, &r->projectionMatrix, sizeof(mat4s)) == 0) {
+    return;
+  }
+  syRendererFlushBatches(r);
+  u->view = r->viewMatrix;
+  u->projection = r->projectionMatrix;
+  u->viewProjection = glms_mul(r->projectionMatrix, r->viewMatrix);
+  glBindBuffer(GL_UNIFORM_BUFFER, r->frameUbo);
+  glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(mat4s) * 3, u);
+  r->gl.stats.bytesUploaded += sizeof(mat4s) * 3;
+}
+
+// Sets the view matrix, and uploads it to the frame uniforms if it changed.
+static inline void syRendererSetViewMatrix(syRenderer *r, mat4s view) {
+  r->viewMatrix = view;
+  syRendererUpdateFrameMatrices(r);
+}
+
+// Sets the projection matrix, and uploads it to the frame uniforms if it
+// changed.
+static inline void syRendererSetProjectionMatrix(syRenderer *r,
+                                                 mat4s projection) {
+  r->projectionMatrix = projection;
+  syRendererUpdateFrameMatrices(r);
+}
+
+// Submits all pending batched draws and executes all recorded commands. Draws
+// that are not recorded call it first, so that they are made after every draw
+// before them.
+static inline void syRendererFlush(syRenderer *r) {
+  syRendererFlushBatches(r);
+  syRendererSubmitCommands(r);
+}
+
+// Makes `target`, `width` by `height` pixels large, the framebuffer that draws
+// go to, where 0 stands for `defaultFramebuffer`. Recorded draws made
+// afterwards are executed after every draw made before, however they are
+// sorted.
+static inline void syRendererSetTarget(syRenderer *r, GLuint target,
+                                       GLsizei width, GLsizei height) {
+  syRendererFlushBatches(r);
+  if (!syCommandBufferBarrier(&r->commands)) {
+    syRendererSubmitCommands(r);
+    // Ends the pass reserved by command lists that are still being recorded
+    syCommandBufferBarrier(&r->commands);
+  }
+  r->target = target;
+  r->targetWidth = width;
+  r->targetHeight = height;
+  syRendererBindTarget(r, target, width, height);
+}
+
+// Merges the keys of the commands recorded in the command list at `list` into
+// the renderer's commands. The commands and their vertex data stay in the list
+// and are executed from there.
+static inline void syRendererMergeCommandList(syRenderer *r, size_t list) {
+  syCommandList *l = r->commandLists.data[list];
+  syCommandListFlush(l);
+  SY_VEC_FOREACH(l->buffer.commands, i) {
+    syCommandBufferPushKey(&r->commands, &l->buffer.commands.data[i],
+                           l->ordered, l->pass, (uint32_t)i,
+                           (uint32_t)list + 1);
+  }
+}
+
+// Merges the command lists begun this frame to be sorted with the other draws
+// if draws are sorted. Otherwise executes them right away, in the order they
+// were begun and with the commands in the order they were recorded in. Must
+// only be called once the threads recording into them are done.
+static inline void syRendererSubmitCommandLists(syRenderer *r) {
+  if (r->commandLists.len == r->numMergedLists) {
+    return;
+  }
+  syRendererFlushBatches(r);
+  for (size_t i = r->numMergedLists; i < r->commandLists.len; i++) {
+    syCommandList *l = r->commandLists.data[i];
+    r->numCulled += l->numCulled;
+    r->numSubmitted += l->numSubmitted;
+    if (r->sorted) {
+      syRendererMergeCommandList(r, i);
+      continue;
+    }
+    syCommandListFlush(l);
+    SY_VEC_FOREACH(l->buffer.commands, j) {
+      syRendererExecute(r, &l->buffer, &l->buffer.commands.data[j]);
+    }
+  }
+  if (r->sorted) {
+    r->numMergedLists = r->commandLists.len;
+    return;
+  }
+  r->commandLists.len = r->numMergedLists;
+  syRendererRestoreState(r);
+}
+
+// Records a draw of vertices, colors and indices, which are copied into the
+// command buffer. `colors` and `indices` may be `NULL`.
+static inline void syRendererRecordStream(syRenderer *r, const float *vertices,
+                                          const float *colors,
+                                          const uint32_t *indices,
+                                          size_t numVertices,
+                                          size_t numIndices, GLenum mode) {
+  syRendererFlushBatches(r);
+  syCommandBuffer *cb = &r->commands;
+  syCommand c = {
+      .type = SY_COMMAND_STREAM,
+      .mode = mode,
+      .program = r->shader,
+      .vertices = syCommandBufferPushData(cb, vertices,
+                                          sizeof(float) * numVertices * 3),
+      .colors = syCommandBufferPushData(cb, colors,
+                                        sizeof(float) * numVertices * 4),
+      .indices = syCommandBufferPushData(cb, indices,
+                                         sizeof(uint32_t) * numIndices),
+      .numVertices = (uint32_t)numVertices,
+      .numIndices = (uint32_t)numIndices,
+      .modelViewProjectionMatrix = *syRendererGetModelViewProjection(r)};
+  memcpy(c.color, r->color, sizeof(r->color));
+  syRendererRecord(r, &c);
+}
+
+// Appends a draw of `mesh` in `pool`, placed by `model` on top of the current
+// transformations, to the indirect batch. Pending draws are flushed when the
+// pool or the model view projection matrix changes, and recorded as one command
+// while commands are sorted.
+static inline void syRendererDrawPooled(syRenderer *r, syMeshPool *pool,
+                                        uint32_t mesh, const mat4s *model) {
+  syIndirectBatch *b = &r->indirect;
+  const mat4s *mvp = syRendererGetModelViewProjection(r);
+  syRendererFlushBatch(r);
+  if (b->commands.len > 0 &&
+      (b->pool != pool || b->matrixVersion != r->matrixVersion)) {
+    syRendererFlushIndirect(r);
+  }
+  // Pools only grow, so commands already collected stay valid after an upload
+  syMeshPoolUpload(&r->gl, pool);
+  if (b->commands.len == 0) {
+    b->pool = pool;
+    b->modelViewProjectionMatrix = *mvp;
+    b->matrixVersion = r->matrixVersion;
+  }
+  const syPooledMesh *m = &pool->meshes.data[mesh];
+  syDrawElementsIndirectCommand command = {
+      .count = m->numIndices,
+      .instanceCount = 1,
+      .firstIndex = m->firstIndex,
+      .baseVertex = m->baseVertex,
+      .baseInstance = (uint32_t)b->commands.len};
+  syColor color = SY_WHITE;
+  if (!m->hasColors) {
+    memcpy(&color, r->color, sizeof(r->color));
+  }
+  syVecPush(b->commands, command);
+  syVecPush(b->transforms, *model);
+  syVecPush(b->colors, color);
+}
+
+// @returns the primitive `mode` is converted to when batched, or `GL_NONE` if
+// draws with `mode` cannot be batched. `n` is set to the number of vertices the
+// draw occupies in the batch.
+static inline GLenum syBatchMode(GLenum mode, size_t *n) {
+  switch (mode) {
+    case GL_POINTS:
+      return GL_POINTS;
+    case GL_LINES:
+      *n -= *n % 2;
+      return GL_LINES;
+    case GL_LINE_STRIP:
+      *n = *n < 2 ? 0 : (*n - 1) * 2;
+      return GL_LINES;
+    case GL_TRIANGLES:
+      *n -= *n % 3;
+      return GL_TRIANGLES;
+    case GL_TRIANGLE_FAN:
+      *n = *n < 3 ? 0 : (*n - 2) * 3;
+      return GL_TRIANGLES;
+    default:
+      return GL_NONE;
+  }
+}
+
+static inline void syBatchPushVertex(syBatch *b, const float *vertices,
+                                     const float *colors, const float *color,
+                                     size_t i) {
+  memcpy(&b->vertices[b->len * 3], &vertices[i * 3], sizeof(float) * 3);
+  if (!b->constantColor) {
+    memcpy(&b->colors[b->len * 4], colors == NULL ? color : &colors[i * 4],
+           sizeof(float) * 4);
+  }
+  b->len++;
+}
+
+// Writes the batch's constant color out to every vertex collected so far.
+static inline void syBatchExpandColors(syBatch *b) {
+  for (size_t i = 0; i < b->len; i++) {
+    memcpy(&b->colors[i * 4], b->color, sizeof(b->color));
+  }
+  b->constantColor = false;
+}
+
+// Appends a draw to the batch. Only draws made with the default shader are
+// batched. Pending vertices are flushed when the primitive type or the model
+// view projection matrix changes, or when the batch is full.
+//
+// @returns `true` if the draw was appended to the batch. Otherwise `false`, in
+// which case the caller is responsible for drawing.
+static inline bool syRendererBatch(syRenderer *r, const float *vertices,
+                                   const float *colors, size_t n, GLenum mode) {
+  syBatch *b = &r->batch;
+  size_t count = n;
+  GLenum batchMode = syBatchMode(mode, &count);
+  if (r->shader != r->defaultShader || batchMode == GL_NONE ||
+      count > b->cap) {
+    return false;
+  }
+  syRendererFlushIndirect(r);
+  const mat4s *mvp = syRendererGetModelViewProjection(r);
+  if (b->len > 0 &&
+      (b->mode != batchMode || b->len + count > b->cap ||
+       b->matrixVersion != r->matrixVersion)) {
+    syRendererFlushBatch(r);
+  }
+  if (b->len == 0) {
+    b->mode = batchMode;
+    b->modelViewProjectionMatrix = *mvp;
+    b->matrixVersion = r->matrixVersion;
+    b->constantColor = colors == NULL;
+    memcpy(b->color, r->color, sizeof(r->color));
+  } else if (b->constantColor &&
+             (colors != NULL ||
+              memcmp(b->color, r->color, sizeof(r->color)) != 0)) {
+    syBatchExpandColors(b);
+  }
+  switch (mode) {
+    case GL_LINE_STRIP:
+      for (size_t i = 1; i < n; i++) {
+        syBatchPushVertex(b, vertices, colors, r->color, i - 1);
+        syBatchPushVertex(b, vertices, colors, r->color, i);
+      }
+      break;
+    case GL_TRIANGLE_FAN:
+      for (size_t i = 2; i < n; i++) {
+        syBatchPushVertex(b, vertices, colors, r->color, 0);
+        syBatchPushVertex(b, vertices, colors, r->color, i - 1);
+        syBatchPushVertex(b, vertices, colors, r->color, i);
+      }
+      break;
+    default:
+      memcpy(&b->vertices[b->len * 3], vertices, sizeof(float) * count * 3);
+      if (!b->constantColor && colors == NULL) {
+        for (size_t i = 0; i < count; i++) {
+          memcpy(&b->colors[(b->len + i) * 4], r->color, sizeof(r->color));
+        }
+      } else if (!b->constantColor) {
+        memcpy(&b->colors[b->len * 4], colors, sizeof(float) * count * 4);
+      }
+      b->len += count;
+      break;
+  }
+  return true;
+}
+
+// @returns the cached mesh of `primitive` with `detail`, or `NULL`.
+static inline syPrimitiveMesh *syRendererFindPrimitive(syRenderer *r,
+                                                       syPrimitive primitive,
+                                                       uint32_t detail) {
+  SY_VEC_FOREACH(r->primitives, i) {
+    syPrimitiveMesh *m = r->primitives.data[i];
+    if (m->primitive == primitive && m->detail == detail) {
+      return m;
+    }
+  }
+  return NULL;
+}
+
+// Uploads the unit mesh of `primitive` into static buffers and caches it.
+// @returns the cached mesh, which stays at the same address until the renderer
+// is destroyed.
+static inline syPrimitiveMesh *syRendererCachePrimitive(
+    syRenderer *r, syPrimitive primitive, uint32_t detail,
+    const float *vertices, size_t numVertices, const uint32_t *indices,
+    size_t numIndices, GLenum mode) {
+  syPrimitiveMesh *m = (syPrimitiveMesh *)calloc(1, sizeof(syPrimitiveMesh));
+  m->primitive = primitive;
+  m->detail = detail;
+  m->vertices = (float *)calloc(numVertices * 3, sizeof(float));
+  memcpy(m->vertices, vertices, sizeof(float) * numVertices * 3);
+  syMeshCreate(&r->gl, &m->mesh, vertices, NULL, numVertices, indices,
+               numIndices, mode);
+  syVecPush(r->primitives, m);
+  return m;
+}
+
+// @returns the counters of the current frame so far.
+static inline syRenderStats syRendererGetStats(const syRenderer *r) {
+  syRenderStats stats = r->gl.stats;
+  stats.elidedBinds = r->gl.elided - r->statsBase.elidedBinds;
+  stats.culled = r->numCulled - r->statsBase.culled;
+  stats.submitted = r->numSubmitted - r->statsBase.submitted;
+  return stats;
+}
+
+// Moves the counters of the current frame to `lastStats` and starts counting
+// the next frame. Called by `main.h` at the start of every frame.
+static inline void syRendererResetStats(syRenderer *r) {
+  r->lastStats = syRendererGetStats(r);
+  r->gl.stats = (syRenderStats){0};
+  r->statsBase = (syRenderStats){.elidedBinds = r->gl.elided,
+                                 .culled = r->numCulled,
+                                 .submitted = r->numSubmitted};
+}
+
+// Flushes the batch and moves the stream buffer on to the next section. Called
+// once per frame before the buffers are swapped.
+static inline void syRendererEndFrame(syRenderer *r) {
+  syRendererFlush(r);
+  syRingBufferAdvance(&r->stream);
+}
+
+static inline void syRendererDestroy(syRenderer *r) {
+  syShaderDestroy(r->instancedShader);
+  if (r->fboShader != 0) {
+    syShaderDestroy(r->fboShader);
+  }
+  SY_VEC_FOREACH(r->primitives, i) {
+    syPrimitiveMesh *m = r->primitives.data[i];
+    syMeshDestroy(&m->mesh);
+    free(m->vertices);
+    free(m);
+  }
+  syVecDestroy(r->primitives);
+  syVecDestroy(r->narrowIndices);
+  syCommandBufferDestroy(&r->commands);
+  syVecDestroy(r->commandLists);
+  syRingBufferDestroy(&r->stream);
+  glDeleteBuffers(1, &r->vbo);
+  glDeleteBuffers(1, &r->cbo);
+  glDeleteBuffers(1, &r->ibo);
+  glDeleteBuffers(1, &r->instanceVbo);
+  glDeleteBuffers(1, &r->instanceCbo);
+  glDeleteBuffers(1, &r->frameUbo);
+  glDeleteBuffers(1, &r->indirectBuffer);
+  glDeleteVertexArrays(1, &r->vao);
+  syVecDestroy(r->indirect.commands);
+  syVecDestroy(r->indirect.transforms);
+  syVecDestroy(r->indirect.colors);
+  free(r->batch.vertices);
+  free(r->batch.colors);
+  r->batch.vertices = NULL;
+  r->batch.colors = NULL;
+  syGlStateDestroy(&r->gl);
 }
 
 #endif  // _SOYA_RENDERER_H
@@ -14,6 +14,7 @@
 #include <soya/core/gl.h>
 #include <soya/core/fbo.h>
 #include <soya/core/app.h>
+#include <soya/core/mesh.h>
 #include <soya/glad/glad.h>
 
 typedef struct syCube {
@@ -52,58 +53,218 @@ static const uint32_t CUBE_INDICES[36] = {
     // Face 6 - Tri 11 - 12
     20, 21, 22, 20, 22, 23};
 
+/**
+ * Order in which the vertices of @ref CUBE_BASE make up the 6 faces of a cube.
+ * */
+static const uint32_t CUBE_FACES[24] = {0, 4, 5, 1, 1, 5, 6, 2, 2, 6, 7, 3,
+                                        3, 7, 4, 0, 4, 7, 6, 5, 3, 0, 1, 2};
+
+/**
+ * Writes the `res * res` vertices and `(res - 1) * res * 6` indices of a unit
+ * sphere centered at the origin.
+ * */
+static inline void sySphereGeometry(uint32_t res, vec3s *vertices,
+                                    uint32_t *indices) {
+  for (uint32_t y = 0; y < res; y++) {
+    float phi = GLM_PIf * 2.0f * (float)(y + 1) / (float)res;
+    for (uint32_t x = 0; x < res; x++) {
+      float theta = GLM_PIf * 2.0f * (float)(x) / (float)res;
+      vertices[y * res + x] = (vec3s){
+          {sinf(phi) * cosf(theta), cosf(phi), sinf(phi) * sinf(theta)}};
+    }
+  }
+  size_t i = 0;
+  for (uint32_t y = 0; y < res - 1; y++) {
+    for (uint32_t x = 0; x < res; x++) {
+      uint32_t i0 = (y * res) + x;
+      uint32_t i1 = (y * res) + ((x + 1) % res);
+      uint32_t i2 = ((y + 1) * res) + x;
+      uint32_t i3 = ((y + 1) * res) + ((x + 1) % res);
+      indices[i++] = i0, indices[i++] = i1, indices[i++] = i2;
+      indices[i++] = i1, indices[i++] = i2, indices[i++] = i3;
+    }
+  }
+}
+
+/**
+ * Writes the `numSides + 2` vertices of a triangle fan forming a polygon with
+ * radius 1 centered at the origin.
+ * */
+static inline void syPolygonGeometry(int numSides, float *vertices) {
+  size_t numItems = (size_t)numSides + 2;
+  vertices[0] = vertices[1] = vertices[2] = 0;
+  float t = GLM_PIf * 2.f / (float)numSides;
+  for (size_t i = 0; i < (size_t)numSides; i++) {
+    vertices[(i + 1) * 3] = cosf(t * (float)i);
+    vertices[(i + 1) * 3 + 1] = sinf(t * (float)i);
+    vertices[(i + 1) * 3 + 2] = 0;
+  }
+  vertices[numItems * 3 - 3] = vertices[3];
+  vertices[numItems * 3 - 2] = vertices[4];
+  vertices[numItems * 3 - 1] = vertices[5];
+}
+
+/**
+ * @returns the cached unit mesh of `primitive`, building and uploading it on
+ * first use. `detail` is the resolution of spheres and number of sides of
+ * polygons, and ignored otherwise. The mesh stays valid until the app exits.
+ * */
+static inline const syPrimitiveMesh *syGetPrimitive(syApp *app,
+                                                    syPrimitive primitive,
+                                                    uint32_t detail) {
+  syRenderer *r = &app->renderer;
+  if (primitive == SY_PRIMITIVE_CUBE || primitive == SY_PRIMITIVE_QUAD) {
+    detail = 0;
+  }
+  const syPrimitiveMesh *cached = syRendererFindPrimitive(r, primitive, detail);
+  if (cached != NULL) {
+    return cached;
+  }
+  switch (primitive) {
+    case SY_PRIMITIVE_CUBE: {
+      vec3s vertices[24];
+      for (size_t i = 0; i < 24; i++) {
+        vertices[i] = CUBE_BASE[CUBE_FACES[i]];
+      }
+      return syRendererCachePrimitive(r, primitive, detail, (float *)vertices,
+                                      24, CUBE_INDICES, 36, GL_TRIANGLES);
+    }
+    case SY_PRIMITIVE_SPHERE: {
+      size_t numVertices = (size_t)detail * detail;
+      size_t numIndices = (size_t)(detail - 1) * detail * 6;
+      vec3s *vertices = (vec3s *)calloc(numVertices, sizeof(vec3s));
+      uint32_t *indices = (uint32_t *)calloc(numIndices, sizeof(uint32_t));
+      sySphereGeometry(detail, vertices, indices);
+      const syPrimitiveMesh *m = syRendererCachePrimitive(
+          r, primitive, detail, (float *)vertices, numVertices, indices,
+          numIndices, GL_TRIANGLES);
+      free((void *)vertices);
+      free((void *)indices);
+      return m;
+    }
+    case SY_PRIMITIVE_POLYGON: {
+      size_t numItems = (size_t)detail + 2;
+      float *vertices = (float *)calloc(numItems * 3, sizeof(float));
+      uint32_t *indices = (uint32_t *)calloc(numItems, sizeof(uint32_t));
+      syPolygonGeometry((int)detail, vertices);
+      for (size_t i = 0; i < numItems; i++) {
+        indices[i] = (uint32_t)i;
+      }
+      const syPrimitiveMesh *m =
+          syRendererCachePrimitive(r, primitive, detail, vertices, numItems,
+                                   indices, numItems, GL_TRIANGLE_FAN);
+      free((void *)vertices);
+      free((void *)indices);
+      return m;
+    }
+    case SY_PRIMITIVE_QUAD:
+    default: {
+      const float vertices[] = {0, 0, 0, 1, 0, 0, 1, 1, 0, 0, 1, 0};
+      const uint32_t indices[] = {0, 1, 2, 0, 2, 3};
+      return syRendererCachePrimitive(r, SY_PRIMITIVE_QUAD, detail, vertices,
+                                      4, indices, 6, GL_TRIANGLES);
+    }
+  }
+}
+
 /**@{*/
+/**
+ * Draws `n` vertices. Draws made with the default shader are collected into the
+ * renderer's batch and submitted together when the batch is flushed.
+ * */
 static inline void syDrawUnindexed(syApp *app, float *vertices, float *colors,
                                    int n, GLenum mode) {
-  glBindVertexArray(app->renderer.vao);
-  syWriteArrayBuffer(app->renderer.vbo, sizeof(float) * (size_t)n * 3,
-                     vertices);
-  syVertexAttribute3f(0);
-
-  if (colors == 0) {
-    float *c = calloc((size_t)n * 4, sizeof(float));
-    for (size_t i = 0; i < n; i++) {
-      memcpy(&c[i * 4], app->renderer.color, sizeof(app->renderer.color));
-    }
-    syWriteArrayBuffer(app->renderer.cbo, sizeof(float) * (size_t)n * 4, c);
-    free(c);
-  } else {
-    syWriteArrayBuffer(app->renderer.cbo, sizeof(float) * (size_t)n * 4,
-                       colors);
+  if (syRendererBatch(&app->renderer, vertices, colors, (size_t)n, mode)) {
+    return;
   }
-  syVertexAttribute4f(1);
+  syRenderer *r = &app->renderer;
+  if (r->sorted) {
+    syRendererRecordStream(r, vertices, colors, NULL, (size_t)n, 0, mode);
+    return;
+  }
+  syRendererFlush(&app->renderer);
+  syGlBindVertexArray(&r->gl, r->vao);
+  syVertexAttribute3fAt(0,
+                        syRendererUpload(r, GL_ARRAY_BUFFER, r->vbo, vertices,
+                                         sizeof(float) * (size_t)n * 3));
+  syRendererSetColors(r, colors, GL_FLOAT, (size_t)n, r->color);
+  syRendererSetShaderUniforms(r, r->shader);
+  glDrawArrays(mode, 0, n);
+  syGlCountDraw(&r->gl, mode, (uint64_t)n, 1);
+}
 
-  syRendererSetShaderUniforms(&app->renderer, app->renderer.shader);
+/**
+ * Draws `n` vertices with packed 8-bit colors, which take 4 instead of 16
+ * bytes per vertex. Unlike @ref syDrawUnindexed, the vertices are never
+ * batched.
+ * */
+static inline void syDrawUnindexedPacked(syApp *app, const float *vertices,
+                                         const syColor8 *colors, int n,
+                                         GLenum mode) {
+  syRendererFlush(&app->renderer);
+  syRenderer *r = &app->renderer;
+  syGlBindVertexArray(&r->gl, r->vao);
+  syVertexAttribute3fAt(0,
+                        syRendererUpload(r, GL_ARRAY_BUFFER, r->vbo, vertices,
+                                         sizeof(float) * (size_t)n * 3));
+  syRendererSetColors(r, colors, GL_UNSIGNED_BYTE, (size_t)n, r->color);
+  syRendererSetShaderUniforms(r, r->shader);
   glDrawArrays(mode, 0, n);
+  syGlCountDraw(&r->gl, mode, (uint64_t)n, 1);
 }
 
+/**
+ * Draws indexed vertices. Indices are uploaded in 16 bits when there are at
+ * most 65536 vertices.
+ * */
 static inline void syDrawIndexed(syApp *app, float *vertices, float *colors,
                                  uint32_t *indices, size_t numVertices,
                                  size_t numIndices, GLenum mode) {
-  glBindVertexArray(app->renderer.vao);
+  syRenderer *r = &app->renderer;
+  if (r->sorted) {
+    syRendererRecordStream(r, vertices, colors, indices, numVertices,
+                           numIndices, mode);
+    return;
+  }
+  syRendererFlush(&app->renderer);
+  syGlBindVertexArray(&r->gl, r->vao);
 
-  syWriteArrayBuffer(app->renderer.vbo, sizeof(float) * numVertices * 3,
-                     vertices);
-  syVertexAttribute3f(0);
+  syVertexAttribute3fAt(0,
+                        syRendererUpload(r, GL_ARRAY_BUFFER, r->vbo, vertices,
+                                         sizeof(float) * numVertices * 3));
+  syRendererSetColors(r, colors, GL_FLOAT, numVertices, r->color);
 
-  if (colors == 0) {
-    float *c = calloc(numVertices * 4, sizeof(float));
-    for (size_t i = 0; i < numVertices; i++) {
-      memcpy(&c[i * 4], app->renderer.color, sizeof(app->renderer.color));
-    }
-    syWriteArrayBuffer(app->renderer.cbo, sizeof(float) * numVertices * 4, c);
-    free(c);
-  } else {
-    syWriteArrayBuffer(app->renderer.cbo, sizeof(float) * numVertices * 4,
-                       colors);
-  }
-  syVertexAttribute4f(1);
+  GLenum type;
+  GLintptr offset =
+      syRendererUploadIndices(r, indices, numIndices, numVertices, &type);
+  syRendererSetShaderUniforms(r, r->shader);
+  glDrawElements(mode, (GLsizei)numIndices, type, (const void *)offset);
+  syGlCountDraw(&r->gl, mode, numIndices, 1);
+}
 
-  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, app->renderer.ibo);
-  glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(uint32_t) * numIndices, indices,
-               GL_DYNAMIC_DRAW);
-  syRendererSetShaderUniforms(&app->renderer, app->renderer.shader);
-  glDrawElements(mode, numIndices, GL_UNSIGNED_INT, 0);
+/**
+ * Draws indexed vertices with packed 8-bit colors. @see syDrawIndexed
+ * */
+static inline void syDrawIndexedPacked(syApp *app, const float *vertices,
+                                       const syColor8 *colors,
+                                       const uint32_t *indices,
+                                       size_t numVertices, size_t numIndices,
+                                       GLenum mode) {
+  syRendererFlush(&app->renderer);
+  syRenderer *r = &app->renderer;
+  syGlBindVertexArray(&r->gl, r->vao);
+
+  syVertexAttribute3fAt(0,
+                        syRendererUpload(r, GL_ARRAY_BUFFER, r->vbo, vertices,
+                                         sizeof(float) * numVertices * 3));
+  syRendererSetColors(r, colors, GL_UNSIGNED_BYTE, numVertices, r->color);
+
+  GLenum type;
+  GLintptr offset =
+      syRendererUploadIndices(r, indices, numIndices, numVertices, &type);
+  syRendererSetShaderUniforms(r, r->shader);
+  glDrawElements(mode, (GLsizei)numIndices, type, (const void *)offset);
+  syGlCountDraw(&r->gl, mode, numIndices, 1);
 }
 
 /**
@@ -143,28 +304,26 @@ static inline void syDrawPolygon(syApp *app, float x, float y, float z,
                                  float radius, int numSides) {
   if (numSides < 3) {
     perror("numSides must be greater than 3");
+    return;
+  }
+  const syPrimitiveMesh *m =
+      syGetPrimitive(app, SY_PRIMITIVE_POLYGON, (uint32_t)numSides);
+  size_t numVertices = m->mesh.numVertices;
+  float stackVertices[SY_POLYGON_STACK_VERTICES * 3];
+  float *vertices = numVertices <= SY_POLYGON_STACK_VERTICES
+                        ? stackVertices
+                        : (float *)calloc(numVertices * 3, sizeof(float));
+  for (size_t i = 0; i < numVertices; i++) {
+    vertices[i * 3] = m->vertices[i * 3] * radius + x;
+    vertices[i * 3 + 1] = m->vertices[i * 3 + 1] * radius + y;
+    vertices[i * 3 + 2] = 0;
   }
-  size_t numItems =
-      (size_t)numSides + 2;  // 1 extra for the center and 1 for the end
-  float *vertices = (float *)calloc(numItems * 3, sizeof(float));
-
-  vertices[0] = x;
-  vertices[1] = y;
   vertices[2] = z;
 
-  float t = GLM_PIf * 2.f / (float)numSides;
-  for (size_t i = 0; i < numSides; i++) {
-    vertices[(i + 1) * 3] = cosf(t * (float)i) * radius + x;
-    vertices[(i + 1) * 3 + 1] = sinf(t * (float)i) * radius + y;
-    vertices[(i + 1) * 3 + 2] = 0;
+  syDrawUnindexed(app, vertices, NULL, (int)numVertices, GL_TRIANGLE_FAN);
+  if (vertices != stackVertices) {
+    free((void *)vertices);
   }
-
-  vertices[numItems * 3 - 3] = vertices[3];
-  vertices[numItems * 3 - 2] = vertices[4];
-  vertices[numItems * 3 - 1] = vertices[5];
-
-  syDrawUnindexed(app, vertices, NULL, numSides + 2, GL_TRIANGLE_FAN);
-  free((void *)vertices);
 }
 
 typedef enum { SY_VERTICAL, SY_HORIZONTAL } syOrientation;
@@ -185,77 +344,341 @@ static inline void syDrawGradientRect(syApp *app, float x, float y, float w,
   syDrawUnindexed(app, vertices, (float *)colors, 4, GL_TRIANGLE_FAN);
 }
 
+/**
+ * Sets up the per-instance attributes of `SY_DEFAULT_INSTANCED_VERTEX_SHADER`
+ * on the bound vertex array.
+ * */
+static inline void sySetInstanceAttributes(syRenderer *r,
+                                           const mat4s *transforms,
+                                           const syColor *instanceColors,
+                                           size_t numInstances) {
+  if (instanceColors == NULL) {
+    syVertexAttributeConstant4f(2, r->color);
+  } else {
+    syVertexAttribute4fAt(2, syRendererUpload(r, GL_ARRAY_BUFFER,
+                                              r->instanceCbo, instanceColors,
+                                              sizeof(syColor) * numInstances));
+    glVertexAttribDivisor(2, 1);
+  }
+  syVertexAttributeInstancedMat4fAt(
+      3, syRendererUpload(r, GL_ARRAY_BUFFER, r->instanceVbo, transforms,
+                          sizeof(mat4s) * numInstances));
+}
+
+static inline void syResetInstanceAttributes(void) {
+  for (GLuint i = 2; i < 7; i++) {
+    glVertexAttribDivisor(i, 0);
+    glDisableVertexAttribArray(i);
+  }
+}
+
+/**
+ * Issues an instanced draw of the indices of `type` bound at `offset` with the
+ * instancing counterpart of the current shader.
+ * */
+static inline void syDrawElementsInstanced(syRenderer *r, GLenum mode,
+                                           size_t numIndices, GLenum type,
+                                           GLintptr offset,
+                                           size_t numInstances) {
+  syShader shader =
+      r->shader == r->defaultShader ? r->instancedShader : r->shader;
+  syGlUseProgram(&r->gl, shader);
+  syRendererSetShaderUniforms(r, shader);
+  glDrawElementsInstanced(mode, (GLsizei)numIndices, type,
+                          (const void *)offset, (GLsizei)numInstances);
+  syGlCountDraw(&r->gl, mode, numIndices, numInstances);
+  syGlUseProgram(&r->gl, r->shader);
+}
+
+/**
+ * Draws a mesh placed by `model` on top of the current transformations. If
+ * `model` is `NULL`, only the current transformations apply. Meshes outside the
+ * view frustum are skipped while culling is enabled.
+ * */
+static inline void syDrawMeshTransformed(syApp *app, const syMesh *mesh,
+                                         const mat4s *model) {
+  syRenderer *r = &app->renderer;
+  syAabb bounds =
+      model == NULL ? mesh->bounds : syAabbTransform(&mesh->bounds, *model);
+  if (!syRendererCullAabb(r, &bounds)) {
+    return;
+  }
+  if (r->sorted) {
+    syRendererFlushBatches(r);
+    syCommand c = {.type = SY_COMMAND_MESH,
+                   .program = r->shader,
+                   .mesh = *mesh,
+                   .modelViewProjectionMatrix =
+                       *syRendererGetModelViewProjection(r)};
+    if (model != NULL) {
+      c.modelViewProjectionMatrix =
+          glms_mul(c.modelViewProjectionMatrix, *model);
+    }
+    memcpy(c.color, r->color, sizeof(r->color));
+    syRendererRecord(r, &c);
+    return;
+  }
+  syRendererFlush(&app->renderer);
+  syGlBindVertexArray(&r->gl, mesh->vao);
+  if (!mesh->hasColors) {
+    syVertexAttributeConstant4f(1, r->color);
+  }
+  if (model == NULL) {
+    syRendererSetShaderUniforms(r, r->shader);
+  } else {
+    mat4s mvp = glms_mul(*syRendererGetModelViewProjection(r), *model);
+    syGlUniformMat4fv(&r->gl, r->shader, "modelViewProjectionMatrix",
+                      (float *)&mvp);
+  }
+  if (mesh->numIndices > 0) {
+    glDrawElements(mesh->mode, (GLsizei)mesh->numIndices, mesh->indexType, 0);
+    syGlCountDraw(&r->gl, mesh->mode, mesh->numIndices, 1);
+  } else {
+    glDrawArrays(mesh->mode, 0, (GLsizei)mesh->numVertices);
+    syGlCountDraw(&r->gl, mesh->mode, mesh->numVertices, 1);
+  }
+}
+
+/**
+ * Draws a mesh with the current transformations. Meshes without colors are
+ * drawn in the current color.
+ * */
+static inline void syDrawMesh(syApp *app, const syMesh *mesh) {
+  syDrawMeshTransformed(app, mesh, NULL);
+}
+
+/**
+ * Draws the mesh with handle `mesh` in `pool`, placed by `model` on top of the
+ * current transformations. Consecutive draws from the same pool are submitted
+ * together with one `glMultiDrawElementsIndirect` call when the renderer is
+ * flushed. Meshes without colors are drawn in the current color, and meshes
+ * outside the view frustum are skipped while culling is enabled.
+ * */
+static inline void syDrawPooledMesh(syApp *app, syMeshPool *pool,
+                                    uint32_t mesh, mat4s model) {
+  syRenderer *r = &app->renderer;
+  syAabb bounds = syAabbTransform(&pool->meshes.data[mesh].bounds, model);
+  if (!syRendererCullAabb(r, &bounds)) {
+    return;
+  }
+  syRendererDrawPooled(r, pool, mesh, &model);
+}
+
+/**
+ * Draws a mesh once for each of the `n` transforms with a single draw call.
+ * @sa syDrawIndexedInstanced
+ * */
+static inline void syDrawMeshInstanced(syApp *app, const syMesh *mesh,
+                                       const mat4s *transforms,
+                                       const syColor *colors, size_t n) {
+  static const float white[4] = {1, 1, 1, 1};
+  if (n == 0) {
+    return;
+  }
+  syRendererFlush(&app->renderer);
+  syRenderer *r = &app->renderer;
+  syGlBindVertexArray(&r->gl, mesh->vao);
+  if (!mesh->hasColors) {
+    syVertexAttributeConstant4f(1, white);
+  }
+  sySetInstanceAttributes(r, transforms, colors, n);
+  if (mesh->numIndices > 0) {
+    syDrawElementsInstanced(r, mesh->mode, mesh->numIndices, mesh->indexType,
+                            0, n);
+  } else {
+    syShader shader =
+        r->shader == r->defaultShader ? r->instancedShader : r->shader;
+    syGlUseProgram(&r->gl, shader);
+    syRendererSetShaderUniforms(r, shader);
+    glDrawArraysInstanced(mesh->mode, 0, (GLsizei)mesh->numVertices,
+                          (GLsizei)n);
+    syGlCountDraw(&r->gl, mesh->mode, mesh->numVertices, n);
+    syGlUseProgram(&r->gl, r->shader);
+  }
+  syResetInstanceAttributes();
+}
+
+/**
+ * Draws the unit mesh of a primitive in the current color, placed by `model`
+ * on top of the current transformations.
+ * */
+static inline void syDrawPrimitive(syApp *app, const syPrimitiveMesh *m,
+                                   mat4s model) {
+  syDrawMeshTransformed(app, &m->mesh, &model);
+}
+
+/**
+ * Draws the unit mesh of a primitive once for each of the `n` transforms.
+ * @sa syDrawIndexedInstanced
+ * */
+static inline void syDrawPrimitiveInstanced(syApp *app,
+                                            const syPrimitiveMesh *m,
+                                            const mat4s *transforms,
+                                            const syColor *colors, size_t n) {
+  syDrawMeshInstanced(app, &m->mesh, transforms, colors, n);
+}
+
+/**
+ * Writes the indices of the boxes in `boxes` that intersect the view frustum of
+ * the current transformations to `visible`, which must hold `n` indices. Use it
+ * to filter the transforms of instanced draws, for example.
+ * @returns the number of visible boxes.
+ * */
+static inline size_t syCullAabbs(syApp *app, const syAabb *boxes, size_t n,
+                                 uint32_t *visible) {
+  const syFrustum *f = syRendererGetFrustum(&app->renderer);
+  size_t numVisible = 0;
+  for (size_t i = 0; i < n; i++) {
+    visible[numVisible] = (uint32_t)i;
+    numVisible += syFrustumTestAabb(f, &boxes[i]);
+  }
+  app->renderer.numCulled += n - numVisible;
+  app->renderer.numSubmitted += numVisible;
+  return numVisible;
+}
+
+/**
+ * Like @ref syCullAabbs, for spheres stored as center (xyz) and radius (w).
+ * */
+static inline size_t syCullSpheres(syApp *app, const vec4s *spheres, size_t n,
+                                   uint32_t *visible) {
+  const syFrustum *f = syRendererGetFrustum(&app->renderer);
+  size_t numVisible = 0;
+  for (size_t i = 0; i < n; i++) {
+    vec3s center = {{spheres[i].x, spheres[i].y, spheres[i].z}};
+    visible[numVisible] = (uint32_t)i;
+    numVisible += syFrustumTestSphere(f, center, spheres[i].w);
+  }
+  app->renderer.numCulled += n - numVisible;
+  app->renderer.numSubmitted += numVisible;
+  return numVisible;
+}
+
 static inline void syDrawCube(syApp *app, const syCube *const cube) {
-  vec3s vertices[] = {
-      // Face 1
-      glms_vec3_add(glms_vec3_scale(CUBE_BASE[0], cube->size), cube->center),
-      glms_vec3_add(glms_vec3_scale(CUBE_BASE[4], cube->size), cube->center),
-      glms_vec3_add(glms_vec3_scale(CUBE_BASE[5], cube->size), cube->center),
-      glms_vec3_add(glms_vec3_scale(CUBE_BASE[1], cube->size), cube->center),
-      // Face 2
-      glms_vec3_add(glms_vec3_scale(CUBE_BASE[1], cube->size), cube->center),
-      glms_vec3_add(glms_vec3_scale(CUBE_BASE[5], cube->size), cube->center),
-      glms_vec3_add(glms_vec3_scale(CUBE_BASE[6], cube->size), cube->center),
-      glms_vec3_add(glms_vec3_scale(CUBE_BASE[2], cube->size), cube->center),
-      // Face 3
-      glms_vec3_add(glms_vec3_scale(CUBE_BASE[2], cube->size), cube->center),
-      glms_vec3_add(glms_vec3_scale(CUBE_BASE[6], cube->size), cube->center),
-      glms_vec3_add(glms_vec3_scale(CUBE_BASE[7], cube->size), cube->center),
-      glms_vec3_add(glms_vec3_scale(CUBE_BASE[3], cube->size), cube->center),
-      // Face 4
-      glms_vec3_add(glms_vec3_scale(CUBE_BASE[3], cube->size), cube->center),
-      glms_vec3_add(glms_vec3_scale(CUBE_BASE[7], cube->size), cube->center),
-      glms_vec3_add(glms_vec3_scale(CUBE_BASE[4], cube->size), cube->center),
-      glms_vec3_add(glms_vec3_scale(CUBE_BASE[0], cube->size), cube->center),
-      // Face 5
-      glms_vec3_add(glms_vec3_scale(CUBE_BASE[4], cube->size), cube->center),
-      glms_vec3_add(glms_vec3_scale(CUBE_BASE[7], cube->size), cube->center),
-      glms_vec3_add(glms_vec3_scale(CUBE_BASE[6], cube->size), cube->center),
-      glms_vec3_add(glms_vec3_scale(CUBE_BASE[5], cube->size), cube->center),
-      // Face 6
-      glms_vec3_add(glms_vec3_scale(CUBE_BASE[3], cube->size), cube->center),
-      glms_vec3_add(glms_vec3_scale(CUBE_BASE[0], cube->size), cube->center),
-      glms_vec3_add(glms_vec3_scale(CUBE_BASE[1], cube->size), cube->center),
-      glms_vec3_add(glms_vec3_scale(CUBE_BASE[2], cube->size), cube->center)};
-  syDrawIndexed(app, (float *)&vertices, NULL, (uint32_t *)CUBE_INDICES, 24, 36,
-                GL_TRIANGLES);
+  mat4s model = glms_translate_make(cube->center);
+  model = glms_scale(model, (vec3s){{cube->size, cube->size, cube->size}});
+  syDrawPrimitive(app, syGetPrimitive(app, SY_PRIMITIVE_CUBE, 0), model);
 }
+
+/**
+ * Draws a sphere. A `radius` of 0 is treated as 1.
+ * */
 static inline void syDrawSphere(syApp *app, const sySphere *const s) {
-  syVec(vec3s) vertices;
-  syVec(uint32_t) indices;
-  syVecInit(vertices, vec3s);
-  syVecInit(indices, uint32_t);
-  int res = s->resolution > 0 ? s->resolution : 32;
-  for (int y = 0; y < res; y++) {
-    float phi = GLM_PIf * 2.0 * (float)(y + 1) / (float)res;
-    for (int x = 0; x < res; x++) {
-      float theta = GLM_PIf * 2.0 * (float)(x) / (float)res;
-      vec3s p = {{sinf(phi) * cosf(theta) + s->center.x,
-                  cosf(phi) + s->center.y,
-                  sinf(phi) * sin(theta) + s->center.z}};
-      syVecPush(vertices, p);
-    }
+  uint32_t res = s->resolution > 0 ? s->resolution : 32;
+  float radius = s->radius > 0 ? s->radius : 1;
+  mat4s model = glms_translate_make(s->center);
+  model = glms_scale(model, (vec3s){{radius, radius, radius}});
+  syDrawPrimitive(app, syGetPrimitive(app, SY_PRIMITIVE_SPHERE, res), model);
+}
+
+/**
+ * Draws `numInstances` copies of an indexed mesh with a single draw call. Each
+ * instance is transformed by its matrix in `transforms` and tinted by its color
+ * in `instanceColors`. If `instanceColors` is `NULL`, all instances use the
+ * current color. If `colors` is `NULL`, the mesh's vertices are white.
+ *
+ * When a custom shader is active, it must declare the attributes of
+ * `SY_DEFAULT_INSTANCED_VERTEX_SHADER`.
+ * */
+static inline void syDrawIndexedInstanced(
+    syApp *app, float *vertices, float *colors, uint32_t *indices,
+    size_t numVertices, size_t numIndices, GLenum mode,
+    const mat4s *transforms, const syColor *instanceColors,
+    size_t numInstances) {
+  static const float white[4] = {1, 1, 1, 1};
+  if (numInstances == 0) {
+    return;
   }
-  for (int y = 0; y < res - 1; y++) {
-    for (int x = 0; x < res; x++) {
-      float i0 = (y * res) + x;
-      float i1 = (y * res) + ((x + 1) % res);
-      float i2 = ((y + 1) * res) + x;
-      float i3 = ((y + 1) * res) + ((x + 1) % res);
-      syVecPush3(indices, i0, i1, i2);
-      syVecPush3(indices, i1, i2, i3);
-    }
+  syRendererFlush(&app->renderer);
+  syRenderer *r = &app->renderer;
+  syGlBindVertexArray(&r->gl, r->vao);
+
+  syVertexAttribute3fAt(0,
+                        syRendererUpload(r, GL_ARRAY_BUFFER, r->vbo, vertices,
+                                         sizeof(float) * numVertices * 3));
+  syRendererSetColors(r, colors, GL_FLOAT, numVertices, white);
+  sySetInstanceAttributes(r, transforms, instanceColors, numInstances);
+
+  GLenum type;
+  GLintptr offset =
+      syRendererUploadIndices(r, indices, numIndices, numVertices, &type);
+  syDrawElementsInstanced(r, mode, numIndices, type, offset, numInstances);
+  syResetInstanceAttributes();
+}
+
+/**
+ * Draws a cube of size 1 centered at the origin for each of the `n` transforms.
+ * @sa syDrawIndexedInstanced
+ * */
+static inline void syDrawCubeInstanced(syApp *app, const mat4s *transforms,
+                                       const syColor *colors, size_t n) {
+  syDrawPrimitiveInstanced(app, syGetPrimitive(app, SY_PRIMITIVE_CUBE, 0),
+                           transforms, colors, n);
+}
+
+/**
+ * Draws a sphere of radius 1 centered at the origin for each of the `n`
+ * transforms.
+ * @sa syDrawIndexedInstanced
+ * */
+static inline void syDrawSphereInstanced(syApp *app, uint32_t resolution,
+                                         const mat4s *transforms,
+                                         const syColor *colors, size_t n) {
+  uint32_t res = resolution > 0 ? resolution : 32;
+  syDrawPrimitiveInstanced(app, syGetPrimitive(app, SY_PRIMITIVE_SPHERE, res),
+                           transforms, colors, n);
+}
+
+/**
+ * Draws a polygon of radius 1 centered at the origin for each of the `n`
+ * transforms.
+ * @sa syDrawIndexedInstanced
+ * */
+static inline void syDrawPolygonInstanced(syApp *app, int numSides,
+                                          const mat4s *transforms,
+                                          const syColor *colors, size_t n) {
+  if (numSides < 3) {
+    perror("numSides must be greater than 3");
+    return;
   }
-  syDrawIndexed(app, (float *)vertices.data, NULL, indices.data, vertices.len,
-                indices.len, GL_TRIANGLES);
-  syVecDestroy(vertices);
-  syVecDestroy(indices);
+  syDrawPrimitiveInstanced(
+      app, syGetPrimitive(app, SY_PRIMITIVE_POLYGON, (uint32_t)numSides),
+      transforms, colors, n);
+}
+
+/**
+ * Draws a quad from (0, 0) to (1, 1) for each of the `n` transforms.
+ * @sa syDrawIndexedInstanced
+ * */
+static inline void syDrawQuadInstanced(syApp *app, const mat4s *transforms,
+                                       const syColor *colors, size_t n) {
+  syDrawPrimitiveInstanced(app, syGetPrimitive(app, SY_PRIMITIVE_QUAD, 0),
+                           transforms, colors, n);
 }
 
 /**@}*/
 
 /**@{ */
-static inline void syClear(syColor col) {
+/**
+ * Submits all batched draws. This only needs to be called before issuing raw
+ * OpenGL calls that depend on previous draws, e.g. `glReadPixels`.
+ * */
+static inline void syFlush(syApp *app) { syRendererFlush(&app->renderer); }
+
+/**
+ * @returns the draw calls, primitives, uploads and binds of the current frame
+ * so far. Batched draws are only counted once they are flushed, so the counts
+ * of the previous frame in `app->renderer.lastStats` are usually more useful.
+ * */
+static inline syRenderStats syGetRenderStats(const syApp *app) {
+  return syRendererGetStats(&app->renderer);
+}
+
+/**
+ * Clears the current framebuffer, after executing all draws made before.
+ * */
+static inline void syClear(syApp *app, syColor col) {
+  syRendererFlush(&app->renderer);
   glClearColor(col.r, col.g, col.b, col.a);
   glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 }
@@ -265,50 +688,432 @@ static inline void sySetColor(syApp *app, syColor col) {
 }
 
 static inline void syTranslate(syApp *app, float x, float y, float z) {
-  app->renderer.modelMatrix =
-      glms_translate(app->renderer.modelMatrix, (vec3s){{x, y, z}});
+  syRendererSetModelMatrix(
+      &app->renderer,
+      glms_translate(app->renderer.modelMatrix, (vec3s){{x, y, z}}));
 }
 
 static inline void syScale(syApp *app, float x, float y, float z) {
-  app->renderer.modelMatrix =
-      glms_scale(app->renderer.modelMatrix, (vec3s){{x, y, z}});
+  syRendererSetModelMatrix(
+      &app->renderer,
+      glms_scale(app->renderer.modelMatrix, (vec3s){{x, y, z}}));
 }
 
 static inline void syRotate(syApp *app, float angle, float x, float y,
                             float z) {
-  app->renderer.modelMatrix =
-      glms_rotate(app->renderer.modelMatrix, angle, (vec3s){{x, y, z}});
+  syRendererSetModelMatrix(
+      &app->renderer,
+      glms_rotate(app->renderer.modelMatrix, angle, (vec3s){{x, y, z}}));
 }
 
 static inline void syResetTransformations(syApp *app) {
-  app->renderer.modelMatrix = glms_mat4_identity();
+  syRendererSetModelMatrix(&app->renderer, glms_mat4_identity());
+}
+
+/**
+ * Saves the current transformations so that they can be restored with
+ * @ref syPopMatrix. At most `SY_MATRIX_STACK_DEPTH` matrices can be pushed.
+ * */
+static inline void syPushMatrix(syApp *app) {
+  syRenderer *r = &app->renderer;
+  if (r->matrixStackLen == SY_MATRIX_STACK_DEPTH) {
+    printf("%s(): Matrix stack overflow\n", __func__);
+    return;
+  }
+  r->matrixStack[r->matrixStackLen++] = r->modelMatrix;
+}
+
+/**
+ * Restores the transformations saved by the last call to @ref syPushMatrix.
+ * */
+static inline void syPopMatrix(syApp *app) {
+  syRenderer *r = &app->renderer;
+  if (r->matrixStackLen == 0) {
+    printf("%s(): Matrix stack underflow\n", __func__);
+    return;
+  }
+  syRendererSetModelMatrix(r, r->matrixStack[--r->matrixStackLen]);
+}
+
+static inline void sySetViewMatrix(syApp *app, mat4s view) {
+  syRendererSetViewMatrix(&app->renderer, view);
+}
+
+static inline void sySetProjectionMatrix(syApp *app, mat4s projection) {
+  syRendererSetProjectionMatrix(&app->renderer, projection);
+}
+
+/**
+ * Uploads the current view and projection matrices, resolution, time and frame
+ * number to the uniform block declared by `SYSL_FRAME_UNIFORMS`. Called before
+ * every `loop()`. View and projection matrices set during the frame with
+ * `sySetViewMatrix` or `sySetProjectionMatrix` are uploaded as they change.
+ * */
+static inline void syUpdateFrameUniforms(syApp *app) {
+  syRenderer *r = &app->renderer;
+  syFrameUniforms u = {
+      .view = r->viewMatrix,
+      .projection = r->projectionMatrix,
+      .viewProjection = glms_mul(r->projectionMatrix, r->viewMatrix),
+      .resolution = {(float)app->width, (float)app->height},
+      .time = (float)app->time,
+      .frameNum = (uint32_t)app->frameNum};
+  syRendererSetFrameUniforms(r, &u);
 }
 /**@}*/
 
 /**@{ */
 static inline void syBeginShader(syApp *app, syShader shader) {
-  glUseProgram(shader);
+  syRendererFlushBatches(&app->renderer);
+  syGlUseProgram(&app->renderer.gl, shader);
   app->renderer.shader = shader;
 }
 
 static inline void syEndShader(syApp *app) {
-  glUseProgram(app->renderer.defaultShader);
+  syRendererFlushBatches(&app->renderer);
+  syGlUseProgram(&app->renderer.gl, app->renderer.defaultShader);
   app->renderer.shader = app->renderer.defaultShader;
 }
+
+/**
+ * Binds the 2D `texture` to texture `unit`, skipping the bind if it is already
+ * current.
+ * */
+static inline void syBindTexture(syApp *app, GLuint unit, GLuint texture) {
+  syGlBindTexture(&app->renderer.gl, unit, texture);
+}
+
+/**
+ * The `sySetUniform*` functions set a uniform of the shader begun with
+ * `syBeginShader`, through the renderer's uniform cache, after making pending
+ * batched draws. Values that did not change are not sent again.
+ * */
+static inline void sySetUniform1f(syApp *app, const char *name, float f) {
+  syRenderer *r = &app->renderer;
+  syRendererFlushBatches(r);
+  syGlUniform1f(&r->gl, r->shader, name, f);
+}
+
+static inline void sySetUniform1i(syApp *app, const char *name, int i) {
+  syRenderer *r = &app->renderer;
+  syRendererFlushBatches(r);
+  syGlUniform1i(&r->gl, r->shader, name, i);
+}
+
+static inline void sySetUniform2f(syApp *app, const char *name, float f1,
+                                  float f2) {
+  syRenderer *r = &app->renderer;
+  syRendererFlushBatches(r);
+  syGlUniform2f(&r->gl, r->shader, name, f1, f2);
+}
+
+static inline void sySetUniform3f(syApp *app, const char *name, float f1,
+                                  float f2, float f3) {
+  syRenderer *r = &app->renderer;
+  syRendererFlushBatches(r);
+  syGlUniform3f(&r->gl, r->shader, name, f1, f2, f3);
+}
+
+static inline void sySetUniform4f(syApp *app, const char *name, float f1,
+                                  float f2, float f3, float f4) {
+  syRenderer *r = &app->renderer;
+  syRendererFlushBatches(r);
+  syGlUniform4f(&r->gl, r->shader, name, f1, f2, f3, f4);
+}
+
+static inline void sySetUniform3fv(syApp *app, const char *name,
+                                   const float *const f) {
+  syRenderer *r = &app->renderer;
+  syRendererFlushBatches(r);
+  syGlUniform3fv(&r->gl, r->shader, name, f);
+}
+
+static inline void sySetUniform4fv(syApp *app, const char *name,
+                                   const float *const f) {
+  syRenderer *r = &app->renderer;
+  syRendererFlushBatches(r);
+  syGlUniform4fv(&r->gl, r->shader, name, f);
+}
+
+static inline void sySetUniformMat4fv(syApp *app, const char *name,
+                                      const float *const value) {
+  syRenderer *r = &app->renderer;
+  syRendererFlushBatches(r);
+  syGlUniformMat4fv(&r->gl, r->shader, name, value);
+}
+
+static inline void sySetRenderStateBit(syApp *app, uint32_t bit,
+                                       bool enabled) {
+  syRenderer *r = &app->renderer;
+  syRendererFlushBatches(r);
+  r->renderState = enabled ? r->renderState | bit : r->renderState & ~bit;
+  syGlSetRenderState(&r->gl, r->renderState);
+}
+
+/**
+ * Enables or disables alpha blending. Default: disabled
+ * */
+static inline void sySetBlend(syApp *app, bool enabled) {
+  sySetRenderStateBit(app, SY_RENDER_STATE_BLEND, enabled);
+}
+
+/**
+ * Enables or disables depth testing. Default: enabled
+ * */
+static inline void sySetDepthTest(syApp *app, bool enabled) {
+  sySetRenderStateBit(app, SY_RENDER_STATE_DEPTH_TEST, enabled);
+}
+
+/**
+ * Turns sorted drawing on or off. While it is on, mesh, primitive and
+ * unindexed or indexed vertex draws are recorded with the framebuffer, render
+ * state, shader, transformation and color they are made with, and executed at
+ * the end of the frame sorted to minimize state, shader and mesh switches.
+ * Draws are only reordered within a pass, which ends whenever `syFboBegin` or
+ * `syFboEnd` switches the framebuffer, so chains of passes keep their order.
+ * Other draws, and `syDrawFbo`, execute everything recorded before them first.
+ *
+ * Uniforms and textures of custom shaders are not recorded, so they should not
+ * change between draws while sorting. Clears execute everything recorded
+ * before them, so draws are only sorted between clears.
+ * */
+static inline void sySetSortedDrawing(syApp *app, bool enabled) {
+  syRendererFlush(&app->renderer);
+  app->renderer.sorted = enabled;
+}
+
+/**
+ * While on, sorted draws are executed in the order they were made, after the
+ * unordered draws of the same pass. Use it for layered 2D drawing.
+ * Blended draws are always ordered.
+ * */
+static inline void sySetOrderedDrawing(syApp *app, bool enabled) {
+  syRendererFlushBatches(&app->renderer);
+  app->renderer.ordered = enabled;
+}
+/**@}*/
+
+/**@{*/
+/**
+ * Starts timing a scope called `name` on the CPU and GPU, which must be a
+ * string that outlives the app, such as a literal. Scopes can be nested and
+ * are ended with `syProfileEnd`. GPU times cover the GL commands issued within
+ * the scope, so call `syFlush` before ending it to include batched draws.
+ * Empty unless profiling is compiled in.
+ * */
+static inline void syProfileBegin(syApp *app, const char *name) {
+  syProfilerBegin(&app->profiler, name);
+}
+
+/**
+ * Ends the innermost scope started with `syProfileBegin`.
+ * */
+static inline void syProfileEnd(syApp *app) { syProfilerEnd(&app->profiler); }
+
+/**
+ * Starts collecting profiled scopes for `syProfileWriteTrace`.
+ * */
+static inline void syProfileStartCapture(syApp *app) {
+  app->profiler.capturing = true;
+}
+
+/**
+ * Writes the scopes collected since `syProfileStartCapture` to `path` as Chrome
+ * trace-event JSON, and stops collecting.
+ * */
+static inline bool syProfileWriteTrace(syApp *app, const char *path) {
+  bool written = syProfilerWriteTrace(&app->profiler, path);
+  app->profiler.capturing = false;
+  return written;
+}
+
+/**
+ * Draws the performance overlay over everything drawn this frame if it is
+ * visible, in a single draw call. Called by the main loop before the buffers
+ * are swapped, after all of the frame's draws have been executed.
+ * */
+static inline void syDrawHud(syApp *app) {
+  if (!app->hud.visible) {
+    return;
+  }
+  syRenderer *r = &app->renderer;
+  syProfileBegin(app, "hud");
+  syRendererFlush(r);
+  bool sorted = r->sorted;
+  GLuint target = r->target;
+  GLsizei targetWidth = r->targetWidth, targetHeight = r->targetHeight;
+  uint32_t renderState = r->renderState;
+  syShader shader = r->shader;
+  mat4s model = r->modelMatrix, view = r->viewMatrix,
+        projection = r->projectionMatrix;
+  r->sorted = false;
+  r->target = 0;
+  r->targetWidth = r->defaultWidth;
+  r->targetHeight = r->defaultHeight;
+  syRendererBindTarget(r, 0, r->defaultWidth, r->defaultHeight);
+  r->renderState = SY_RENDER_STATE_BLEND;
+  syGlSetRenderState(&r->gl, r->renderState);
+  syGlUseProgram(&r->gl, r->defaultShader);
+  r->shader = r->defaultShader;
+  syRendererSetProjectionMatrix(
+      r, glms_ortho(0, (float)app->width, 0, (float)app->height, 0.1f, 100.0));
+  syRendererSetViewMatrix(r, glms_translate_make((vec3s){{0, 0, -1}}));
+  syRendererSetModelMatrix(r, glms_mat4_identity());
+
+  syFrameStatsUpdate(&app->frameStats);
+  syHudBuild(&app->hud, &app->frameStats, &app->profiler, &r->lastStats,
+             app->height);
+  syDrawUnindexed(app, app->hud.vertices.data, app->hud.colors.data,
+                  (int)(app->hud.vertices.len / 3), GL_TRIANGLES);
+  syRendererFlushBatches(r);
+
+  syRendererSetProjectionMatrix(r, projection);
+  syRendererSetViewMatrix(r, view);
+  syRendererSetModelMatrix(r, model);
+  syGlUseProgram(&r->gl, shader);
+  r->shader = shader;
+  r->renderState = renderState;
+  syGlSetRenderState(&r->gl, renderState);
+  r->target = target;
+  r->targetWidth = targetWidth;
+  r->targetHeight = targetHeight;
+  syRendererBindTarget(r, target, targetWidth, targetHeight);
+  r->sorted = sorted;
+  syProfileEnd(app);
+}
+/**@}*/
+
+/**@{*/
+/**
+ * Clears `list` and captures the current shader, framebuffer, render state,
+ * transformations and color for recording into it, then queues it to be
+ * merged into the frame's draws. Call it on the main thread, then hand the list
+ * to a worker thread, which records with the `syCommandList*` functions
+ * without making any GL calls.
+ *
+ * Queued lists are drawn before the buffers are swapped, in the order they
+ * were begun and after everything drawn on the main thread, unless sorted
+ * drawing is on and they are sorted with the other draws of the target they
+ * were begun with. Their mesh draws are culled if `culling` is on. The threads
+ * recording them must be done by the time `loop()` returns. Beginning a list
+ * that is already queued clears it without queueing it again.
+ * */
+static inline void syBeginCommandList(syApp *app, syCommandList *list) {
+  syRenderer *r = &app->renderer;
+  // Merged commands are executed from their list, so they must be executed
+  // before the list is recorded into again
+  bool queued = false;
+  for (size_t i = 0; i < r->commandLists.len && !queued; i++) {
+    if (r->commandLists.data[i] != list) {
+      continue;
+    }
+    if (i < r->numMergedLists) {
+      syRendererFlush(r);
+      break;
+    }
+    queued = true;
+  }
+  syCommandListReset(list, *syRendererGetModelViewProjection(r), r->shader,
+                     r->target, r->targetWidth, r->targetHeight,
+                     r->renderState, r->ordered, r->culling,
+                     r->color);
+  list->pass = syCommandBufferReservePass(&r->commands);
+  if (!queued) {
+    syVecPush(r->commandLists, list);
+  }
+}
+
+/**
+ * Merges and draws the queued command lists right away, for example to draw
+ * an FBO they drew into. The threads recording them must be done.
+ * */
+static inline void sySubmitCommandLists(syApp *app) {
+  syRendererSubmitCommandLists(&app->renderer);
+}
 /**@}*/
 
 /**@{*/
-static inline void syFboBegin(syFbo *fbo) {
-  glBindFramebuffer(GL_FRAMEBUFFER, fbo->framebuffer);
+/**
+ * Makes `fbo` the target of the following draws, with the viewport set to its
+ * size.
+ * */
+static inline void syFboBegin(syApp *app, syFbo *fbo) {
+  syRendererSetTarget(&app->renderer, fbo->framebuffer, fbo->options.width,
+                      fbo->options.height);
 }
 
-static inline void syFboEnd(void) { glBindFramebuffer(GL_FRAMEBUFFER, 0); }
+/**
+ * Makes the window, or the headless target, the target of the following draws
+ * again.
+ * */
+static inline void syFboEnd(syApp *app) {
+  syRenderer *r = &app->renderer;
+  syRendererSetTarget(r, 0, r->defaultWidth, r->defaultHeight);
+}
+
+/**
+ * Deletes `fbo`, which must not be drawing, after executing the draws made
+ * before. The renderer's bindings are forgotten, since GL may give the deleted
+ * names to new objects.
+ * */
+static inline void syDestroyFbo(syApp *app, syFbo *fbo) {
+  syRendererFlush(&app->renderer);
+  _syFboDestroy(fbo);
+  syGlStateInvalidate(&app->renderer.gl);
+}
 
+/**
+ * @returns a temporary render target created with `options`, which is only
+ * used by the caller until the next frame begins. Targets are recycled, so
+ * after the first frames no FBO or program is created.
+ * */
+static inline syFbo *syAcquireFbo(syApp *app, const syFboOptions *options) {
+  return syFboPoolAcquire(&app->fboPool, options);
+}
+
+/**
+ * @returns two temporary render targets created with `options`, for chains of
+ * passes that each read the result of the previous one.
+ * */
+static inline syFboPingPong syAcquireFboPingPong(syApp *app,
+                                                 const syFboOptions *options) {
+  return syFboPoolAcquirePingPong(&app->fboPool, options);
+}
+
+/**
+ * Keeps a target acquired with `syAcquireFbo` across frames until it is
+ * released, for feedback effects that read the previous frame.
+ * */
+static inline void syHoldFbo(syApp *app, const syFbo *fbo) {
+  syFboPoolHold(&app->fboPool, fbo);
+}
+
+// Returns a target acquired with `syAcquireFbo` before the frame ends.
+static inline void syReleaseFbo(syApp *app, const syFbo *fbo) {
+  syFboPoolRelease(&app->fboPool, fbo);
+}
+
+/**
+ * Draws the FBO's texture over the whole window. All draws made before are
+ * executed first, and the FBO is drawn right away even while commands are
+ * sorted, since it samples what they drew. Red textures are drawn as gray, and
+ * alpha is kept for textures with four channels. Integer and depth textures
+ * cannot be drawn.
+ * */
 static inline void syDrawFbo(syApp *app, syFbo *fbo) {
-  syBeginShader(app, fbo->shader);
-  syShaderUniformTexture(fbo->shader, "tex0", fbo->texture);
-  syShaderUniform2f(fbo->shader, "res", (float)app->width, (float)app->height);
+  syRenderer *r = &app->renderer;
+  syRendererFlush(r);
+  if (r->fboShader == 0) {
+    r->fboShader = syShaderProgramLoadFromSource(SY_RGB_FBO_FRAGMENT_SHADER,
+                                                 SY_DEFAULT_VERTEX_SHADER);
+  }
+  syBeginShader(app, r->fboShader);
+  syBindTexture(app, 0, fbo->texture);
+  syGlUniform1i(&r->gl, r->fboShader, "tex0", 0);
+  syGlUniform1i(&r->gl, r->fboShader, "channels",
+                syFboChannels(fbo->options.internalFormat));
   syDrawQuad(app, 0, 0, (float)app->width, (float)app->height);
   syEndShader(app);
+  syRendererFlush(&app->renderer);
 }
 /**@}*/
@@ -5,16 +5,170 @@
 #define _SOYA_SHADER_H
 
 #include <stdio.h>
+#include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 #include <stdbool.h>
 
 #include <soya/lib/preprocessor.h>
+#include <soya/core/gl.h>
+#include <soya/core/defaults.h>
 #include <soya/core/defaultshaders.h>
 
 #include <soya/glad/glad.h>
 
 typedef GLuint syShader;
 
+// FNV-1a hash of a uniform name.
+static inline uint32_t syUniformHash(const char *name) {
+  uint32_t hash = 2166136261u;
+  for (const char *c = name; *c != '\0'; c++) {
+    hash = (hash ^ (uint8_t)*c) * 16777619u;
+  }
+  return hash;
+}
+
+// @returns the slot for `program` in the uniform tables of `s`, or `NULL` if
+// `program` is 0, or has no table and there is no room left for one.
+static inline syUniformTable *syUniformTableSlot(syGlState *s,
+                                                 GLuint program) {
+  if (program == 0 || s->uniformTables == NULL) {
+    return NULL;
+  }
+  size_t start = program % SY_MAX_SHADER_PROGRAMS;
+  syUniformTable *empty = NULL;
+  for (size_t i = 0; i < SY_MAX_SHADER_PROGRAMS; i++) {
+    syUniformTable *t =
+        &s->uniformTables[(start + i) % SY_MAX_SHADER_PROGRAMS];
+    if (t->program == program) {
+      return t;
+    }
+    if (t->program == 0 && empty == NULL) {
+      empty = t;
+    }
+  }
+  return empty;
+}
+
+static inline syUniform *syUniformTableAdd(syUniformTable *t, const char *name,
+                                           GLint location) {
+  if (t->len == t->cap) {
+    t->cap = t->cap == 0 ? 8 : t->cap * 2;
+    t->uniforms =
+        (syUniform *)realloc(t->uniforms, t->cap * sizeof(syUniform));
+  }
+  syUniform *u = &t->uniforms[t->len++];
+  u->hash = syUniformHash(name);
+  u->name = (char *)malloc(strlen(name) + 1);
+  strcpy(u->name, name);
+  u->location = location;
+  u->set = false;
+  return u;
+}
+
+// Frees the uniform table of `program`. Does nothing if `s` is `NULL`.
+static inline void syShaderForget(syGlState *s, GLuint program) {
+  if (s == NULL) {
+    return;
+  }
+  syUniformTable *t = syUniformTableSlot(s, program);
+  if (t == NULL || t->program != program) {
+    return;
+  }
+  for (size_t i = 0; i < t->len; i++) {
+    free(t->uniforms[i].name);
+  }
+  free(t->uniforms);
+  *t = (syUniformTable){0};
+}
+
+// Builds the uniform table of a linked `program` from its active uniforms,
+// replacing any table it had.
+// @returns the table, or `NULL` if `program` is 0 or there are more than
+// `SY_MAX_SHADER_PROGRAMS` programs.
+static inline syUniformTable *syShaderReflect(syGlState *s, GLuint program) {
+  syShaderForget(s, program);
+  syUniformTable *t = syUniformTableSlot(s, program);
+  if (t == NULL) {
+    return NULL;
+  }
+  t->program = program;
+  GLint numUniforms = 0;
+  glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &numUniforms);
+  for (GLint i = 0; i < numUniforms; i++) {
+    char name[256];
+    GLsizei len = 0;
+    GLint size = 0;
+    GLenum type = 0;
+    glGetActiveUniform(program, (GLuint)i, sizeof(name), &len, &size, &type,
+                       name);
+    GLint location = glGetUniformLocation(program, name);
+    // Members of uniform blocks have no location
+    if (location < 0) {
+      continue;
+    }
+    // Arrays are reported as `name[0]`, but are usually set by `name`
+    if (len > 3 && strcmp(&name[len - 3], "[0]") == 0) {
+      name[len - 3] = '\0';
+    }
+    syUniformTableAdd(t, name, location);
+  }
+  return t;
+}
+
+// Looks up the cached location of `name` and compares `value` with the value
+// last sent to it. Programs made by the `syShader*ProgramLoad*` functions are
+// reflected when they are linked; others are reflected on first use.
+//
+// Without a state `s`, the location is looked up and the value always sent.
+//
+// @returns `true` if the uniform exists in `shader` and `value` differs from
+// its current value, in which case the caller must send `value` to `*location`.
+static inline bool syShaderUniformChanged(syGlState *s, GLuint shader,
+                                          const char *name, const void *value,
+                                          size_t size, GLint *location) {
+  *location = -1;
+  if (shader == 0) {
+    return false;
+  }
+  syUniformTable *t = s == NULL ? NULL : syUniformTableSlot(s, shader);
+  if (t == NULL) {
+    *location = glGetUniformLocation(shader, name);
+    if (s != NULL) {
+      s->stats.uniformUploads += *location >= 0;
+    }
+    return *location >= 0;
+  }
+  if (t->program != shader) {
+    t = syShaderReflect(s, shader);
+  }
+  uint32_t hash = syUniformHash(name);
+  syUniform *u = NULL;
+  for (size_t i = 0; i < t->len && u == NULL; i++) {
+    if (t->uniforms[i].hash == hash && strcmp(t->uniforms[i].name, name) == 0) {
+      u = &t->uniforms[i];
+    }
+  }
+  if (u == NULL) {
+    u = syUniformTableAdd(t, name, glGetUniformLocation(shader, name));
+  }
+  *location = u->location;
+  if (u->location < 0) {
+    return false;
+  }
+  if (size > sizeof(u->value)) {
+    s->stats.uniformUploads++;
+    return true;
+  }
+  if (u->set && memcmp(u->value, value, size) == 0) {
+    return false;
+  }
+  memcpy(u->value, value, size);
+  u->set = true;
+  s->stats.uniformUploads++;
+  return true;
+}
+
 // @returns the info log to `shader` as a `const char *` owned by the caller.
 static inline const char *syShaderInfoLog(const GLuint shader) {
   char *buffer = (char *)malloc(512);
@@ -59,9 +213,38 @@ static inline GLuint syShaderProgramLoadFromSource(
   glLinkProgram(shader);
   glDeleteShader(vs);
   glDeleteShader(fs);
+  if (syGlCurrentState != NULL) {
+    syShaderReflect(syGlCurrentState, shader);
+  }
+  return shader;
+}
+
+// @returns a program consisting of the compute shader compiled from
+// `computeShaderSource`.
+static inline GLuint syShaderComputeProgramLoadFromSource(
+    const char *computeShaderSource) {
+  const GLuint cs =
+      syShaderLoadFromSource(computeShaderSource, GL_COMPUTE_SHADER);
+  const GLuint shader = glCreateProgram();
+  glAttachShader(shader, cs);
+  glLinkProgram(shader);
+  glDeleteShader(cs);
+  if (syGlCurrentState != NULL) {
+    syShaderReflect(syGlCurrentState, shader);
+  }
   return shader;
 }
 
+// Deletes `shader` and drops its uniform table from the current `syGlState`,
+// so a later program GL gives the same name is reflected again.
+static inline void syShaderDestroy(syShader shader) {
+  syShaderForget(syGlCurrentState, shader);
+  if (syGlCurrentState != NULL && syGlCurrentState->program == shader) {
+    syGlCurrentState->program = 0;
+  }
+  glDeleteProgram(shader);
+}
+
 static inline GLuint syShaderProgramLoadDefault(void) {
   return syShaderProgramLoadFromSource(SY_DEFAULT_FRAGMENT_SHADER,
                                        SY_DEFAULT_VERTEX_SHADER);
@@ -77,54 +260,144 @@ static inline GLuint syShaderLoadFromFile(char *shaderPath, GLenum shaderType) {
   return shader;
 }
 
+static inline void syGlUniform1f(syGlState *s, GLuint shader,
+                                 const char *uniformName, float f) {
+  GLint u;
+  if (syShaderUniformChanged(s, shader, uniformName, &f, sizeof(f), &u)) {
+    glUniform1f(u, f);
+  }
+}
+
+static inline void syGlUniform1i(syGlState *s, GLuint shader,
+                                 const char *uniformName, int i) {
+  GLint u;
+  if (syShaderUniformChanged(s, shader, uniformName, &i, sizeof(i), &u)) {
+    glUniform1i(u, i);
+  }
+}
+
+static inline void syGlUniform2f(syGlState *s, GLuint shader,
+                                 const char *uniformName, float f1, float f2) {
+  const float v[2] = {f1, f2};
+  GLint u;
+  if (syShaderUniformChanged(s, shader, uniformName, v, sizeof(v), &u)) {
+    glUniform2f(u, f1, f2);
+  }
+}
+
+static inline void syGlUniform3f(syGlState *s, GLuint shader,
+                                 const char *uniformName, float f1, float f2,
+                                 float f3) {
+  const float v[3] = {f1, f2, f3};
+  GLint u;
+  if (syShaderUniformChanged(s, shader, uniformName, v, sizeof(v), &u)) {
+    glUniform3f(u, f1, f2, f3);
+  }
+}
+
+static inline void syGlUniform4f(syGlState *s, GLuint shader,
+                                 const char *uniformName, float f1, float f2,
+                                 float f3, float f4) {
+  const float v[4] = {f1, f2, f3, f4};
+  GLint u;
+  if (syShaderUniformChanged(s, shader, uniformName, v, sizeof(v), &u)) {
+    glUniform4f(u, f1, f2, f3, f4);
+  }
+}
+
+static inline void syGlUniform3fv(syGlState *s, GLuint shader,
+                                  const char *uniformName,
+                                  const float *const f) {
+  GLint u;
+  if (syShaderUniformChanged(s, shader, uniformName, f, sizeof(float) * 3,
+                             &u)) {
+    glUniform3fv(u, 1, f);
+  }
+}
+
+static inline void syGlUniform4fv(syGlState *s, GLuint shader,
+                                  const char *uniformName,
+                                  const float *const f) {
+  GLint u;
+  if (syShaderUniformChanged(s, shader, uniformName, f, sizeof(float) * 4,
+                             &u)) {
+    glUniform4fv(u, 1, f);
+  }
+}
+
+static inline void syGlUniformMat4fv(syGlState *s, GLuint shader,
+                                     const char *uniformName,
+                                     const float *const value) {
+  GLint u;
+  if (syShaderUniformChanged(s, shader, uniformName, value,
+                             sizeof(float) * 16, &u)) {
+    glUniformMatrix4fv(u, 1, GL_FALSE, value);
+  }
+}
+
+// Binds `texture` to texture unit `texture` through the binding cache of `s`,
+// or with raw GL calls without a state, and points `name` at that unit.
+static inline void syGlUniformTexture(syGlState *s, GLuint shader,
+                                      const char *name, GLuint texture) {
+  if (s != NULL) {
+    syGlBindTexture(s, texture, texture);
+  } else {
+    glActiveTexture(GL_TEXTURE0 + texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+  }
+  const GLint unit = (GLint)texture;
+  GLint uTex;
+  if (syShaderUniformChanged(s, shader, name, &unit, sizeof(unit), &uTex)) {
+    glUniform1i(uTex, unit);
+  }
+}
+
+// The `syShaderUniform*` functions set uniforms through the uniform cache of
+// `syGlCurrentState`, the renderer's state once the app is running.
+
 static inline void syShaderUniform1f(GLuint shader, const char *uniformName,
                                      float f) {
-  GLint u = glGetUniformLocation(shader, uniformName);
-  glUniform1f(u, f);
+  syGlUniform1f(syGlCurrentState, shader, uniformName, f);
+}
+
+static inline void syShaderUniform1i(GLuint shader, const char *uniformName,
+                                     int i) {
+  syGlUniform1i(syGlCurrentState, shader, uniformName, i);
 }
 
 static inline void syShaderUniform2f(GLuint shader, const char *uniformName,
                                      float f1, float f2) {
-  GLint u = glGetUniformLocation(shader, uniformName);
-  glUniform2f(u, f1, f2);
+  syGlUniform2f(syGlCurrentState, shader, uniformName, f1, f2);
 }
 
 static inline void syShaderUniform3f(GLuint shader, const char *uniformName,
                                      float f1, float f2, float f3) {
-  GLint u = glGetUniformLocation(shader, uniformName);
-  glUniform3f(u, f1, f2, f3);
+  syGlUniform3f(syGlCurrentState, shader, uniformName, f1, f2, f3);
 }
 
 static inline void syShaderUniform4f(GLuint shader, const char *uniformName,
                                      float f1, float f2, float f3, float f4) {
-  GLint u = glGetUniformLocation(shader, uniformName);
-  glUniform4f(u, f1, f2, f3, f4);
+  syGlUniform4f(syGlCurrentState, shader, uniformName, f1, f2, f3, f4);
 }
 
 static inline void syShaderUniform3fv(GLuint shader, const char *uniformName,
                                       const float *const f) {
-  GLint u = glGetUniformLocation(shader, uniformName);
-  glUniform3fv(u, 1, f);
+  syGlUniform3fv(syGlCurrentState, shader, uniformName, f);
 }
 
 static inline void syShaderUniform4fv(GLuint shader, const char *uniformName,
                                       const float *const f) {
-  GLint u = glGetUniformLocation(shader, uniformName);
-  glUniform4fv(u, 1, f);
+  syGlUniform4fv(syGlCurrentState, shader, uniformName, f);
 }
 
 static inline void syShaderUniformMat4fv(GLuint shader, const char *uniformName,
                                          const float *const value) {
-  GLint u = glGetUniformLocation(shader, uniformName);
-  glUniformMatrix4fv(u, 1, GL_FALSE, value);
+  syGlUniformMat4fv(syGlCurrentState, shader, uniformName, value);
 }
 
 static inline void syShaderUniformTexture(GLuint shader, const char *name,
                                           GLuint texture) {
-  glActiveTexture(GL_TEXTURE0 + texture);
-  glBindTexture(GL_TEXTURE_2D, texture);
-  GLint uTex = glGetUniformLocation(shader, name);
-  glUniform1i(uTex, (GLint)texture);
+  syGlUniformTexture(syGlCurrentState, shader, name, texture);
 }
 
 #endif  // _SOYA_SHADER_H
@@ -0,0 +1,342 @@
+//
+// syParticles
+//
+// A CPU particle system that stores its particles as structure of arrays and
+// updates them in parallel on a pool of worker threads. Positions are written
+// out to a contiguous xyz buffer that can be passed to `syDrawUnindexed`.
+//
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#ifndef _SOYA_PARTICLES_H
+#define _SOYA_PARTICLES_H
+
+// Alignment of every particle array in bytes
+#define SY_PARTICLES_ALIGNMENT 64
+
+// Number of particles the ranges handed to the threads are rounded to, so that
+// no two threads write to the same cache line.
+#define SY_PARTICLES_CHUNK (SY_PARTICLES_ALIGNMENT / sizeof(float))
+
+typedef struct syParticles syParticles;
+
+// Applies forces to the particles in [`begin`, `end`), usually by changing
+// their velocities. Called from several threads at once with disjoint ranges.
+typedef void (*syParticlesForce)(syParticles *p, size_t begin, size_t end,
+                                 float dt, void *userData);
+
+typedef struct syParticlesOptions syParticlesOptions;
+
+// Allocates the particle arrays and starts the worker threads. All particles
+// are spawned on the first update.
+// @returns false if the arrays could not be allocated, in which case nothing
+// is left allocated and `p` must not be updated or destroyed.
+static inline bool syParticlesInit(syParticles *p,
+                                   const syParticlesOptions *opts);
+
+// Advances the particles by `dt` seconds: respawns dead particles, applies the
+// force, integrates velocities and writes `positions`. Blocks until every
+// thread is done.
+static inline void syParticlesUpdate(syParticles *p, float dt);
+
+// Stops the worker threads and frees the particle arrays.
+static inline void syParticlesDestroy(syParticles *p);
+
+typedef struct syParticlesOptions {
+  size_t count;
+  // Number of threads updating the particles, including the calling thread.
+  // Default: number of online processors
+  size_t numThreads;
+  // Particles respawn at a random point within this box, moving in a random
+  // direction at `speed` units per second. Axes along which the box has no
+  // extent are not moved along.
+  float spawnMin[3], spawnMax[3];
+  float speed;
+  // Lifetime range in seconds
+  float minLifetime, maxLifetime;
+  // Optional force applied every update
+  syParticlesForce force;
+  void *userData;
+} syParticlesOptions;
+
+typedef struct syParticles {
+  size_t count;
+  // Structure of arrays, each aligned to `SY_PARTICLES_ALIGNMENT`
+  float *x, *y, *z;
+  float *vx, *vy, *vz;
+  float *age, *lifetime;
+  // Contiguous xyz positions of all particles, written on every update
+  float *positions;
+  syParticlesOptions opts;
+
+  // Worker pool. Thread 0 is the thread calling `syParticlesUpdate`. Only
+  // counts the workers that were started.
+  size_t numThreads;
+  pthread_t *threads;
+  pthread_mutex_t mutex;
+  pthread_cond_t start, done;
+  uint64_t generation;
+  size_t pending;
+  bool quit;
+  float dt;
+} syParticles;
+
+typedef struct _syParticlesWorker {
+  syParticles *p;
+  size_t index;
+} _syParticlesWorker;
+
+// @returns `size` zeroed bytes aligned to `SY_PARTICLES_ALIGNMENT`, or `NULL`.
+// At least one block is allocated so that empty systems get valid pointers too.
+static inline void *_syParticlesAlloc(size_t size) {
+  size_t aligned = (size + SY_PARTICLES_ALIGNMENT - 1) /
+                   SY_PARTICLES_ALIGNMENT * SY_PARTICLES_ALIGNMENT;
+  if (aligned == 0) {
+    aligned = SY_PARTICLES_ALIGNMENT;
+  }
+  void *data = aligned_alloc(SY_PARTICLES_ALIGNMENT, aligned);
+  if (data != NULL) {
+    memset(data, 0, aligned);
+  }
+  return data;
+}
+
+static inline uint32_t _syParticlesHash(uint32_t x) {
+  x ^= x >> 16;
+  x *= 0x7feb352du;
+  x ^= x >> 15;
+  x *= 0x846ca68bu;
+  return x ^ (x >> 16);
+}
+
+// Advances the Weyl sequence `state` and @returns its hash as a random float in
+// [0, 1). Each particle seeds its own state from its index, rather than all
+// particles drawing from one sequence, so results do not depend on how they are
+// split across threads.
+static inline float _syParticlesRandf(uint32_t *state) {
+  *state += 0x9e3779b9u;
+  uint32_t r = _syParticlesHash(*state);
+  return (float)(int32_t)(r >> 8) * (1.f / 16777216.f);
+}
+
+// @returns `b` where the bits of `mask` are set, else `a`. Used instead of
+// branches or the ternary operator so that loops stay vectorizable.
+static inline float _syParticlesSelect(float a, float b, uint32_t mask) {
+  uint32_t ua, ub;
+  memcpy(&ua, &a, sizeof(ua));
+  memcpy(&ub, &b, sizeof(ub));
+  ua = (ua & ~mask) | (ub & mask);
+  memcpy(&a, &ua, sizeof(a));
+  return a;
+}
+
+// The kernels below take their arrays as `restrict` parameters and select with
+// bit masks instead of branching so that the compiler vectorizes their loops.
+
+// Respawns the dead particles in [`begin`, `end`) within the box `lo`-`hi`,
+// with velocities of up to `speed` along each axis and lifetimes between
+// `minLifetime` and `maxLifetime`.
+static inline void _syParticlesRespawnKernel(
+    float *restrict x, float *restrict y, float *restrict z,
+    float *restrict vx, float *restrict vy, float *restrict vz,
+    float *restrict age, float *restrict lifetime, size_t begin, size_t end,
+    const float lo[3], const float hi[3], const float speed[3],
+    float minLifetime, float maxLifetime, uint32_t seed) {
+  const float lx = lo[0], ly = lo[1], lz = lo[2];
+  const float ex = hi[0] - lo[0], ey = hi[1] - lo[1], ez = hi[2] - lo[2];
+  const float sx = speed[0], sy = speed[1], sz = speed[2];
+  const float el = maxLifetime - minLifetime;
+  for (size_t i = begin; i < end; i++) {
+    uint32_t state = _syParticlesHash((uint32_t)i ^ seed);
+    uint32_t dead = -(uint32_t)(age[i] >= lifetime[i]);
+    x[i] = _syParticlesSelect(x[i], lx + ex * _syParticlesRandf(&state), dead);
+    y[i] = _syParticlesSelect(y[i], ly + ey * _syParticlesRandf(&state), dead);
+    z[i] = _syParticlesSelect(z[i], lz + ez * _syParticlesRandf(&state), dead);
+    vx[i] = _syParticlesSelect(
+        vx[i], sx * (_syParticlesRandf(&state) * 2.f - 1.f), dead);
+    vy[i] = _syParticlesSelect(
+        vy[i], sy * (_syParticlesRandf(&state) * 2.f - 1.f), dead);
+    vz[i] = _syParticlesSelect(
+        vz[i], sz * (_syParticlesRandf(&state) * 2.f - 1.f), dead);
+    lifetime[i] = _syParticlesSelect(
+        lifetime[i], minLifetime + el * _syParticlesRandf(&state), dead);
+    age[i] = _syParticlesSelect(age[i], 0.f, dead);
+  }
+}
+
+// Integrates the particles in [`begin`, `end`) and writes their positions into
+// `out`.
+static inline void _syParticlesIntegrateKernel(
+    float *restrict x, float *restrict y, float *restrict z,
+    const float *restrict vx, const float *restrict vy,
+    const float *restrict vz, float *restrict age, float *restrict out,
+    size_t begin, size_t end, float dt) {
+  for (size_t i = begin; i < end; i++) {
+    x[i] += vx[i] * dt;
+    y[i] += vy[i] * dt;
+    z[i] += vz[i] * dt;
+    age[i] += dt;
+  }
+  for (size_t i = begin; i < end; i++) {
+    out[i * 3] = x[i];
+    out[i * 3 + 1] = y[i];
+    out[i * 3 + 2] = z[i];
+  }
+}
+
+static inline void _syParticlesUpdateRange(syParticles *p, size_t index) {
+  size_t perThread = (p->count + p->numThreads - 1) / p->numThreads;
+  size_t chunk =
+      (perThread + SY_PARTICLES_CHUNK - 1) / SY_PARTICLES_CHUNK *
+      SY_PARTICLES_CHUNK;
+  size_t begin = index * chunk < p->count ? index * chunk : p->count;
+  size_t end = begin + chunk < p->count ? begin + chunk : p->count;
+  if (begin == end) {
+    return;
+  }
+  const syParticlesOptions *o = &p->opts;
+  float speed[3];
+  for (size_t a = 0; a < 3; a++) {
+    speed[a] = o->spawnMin[a] != o->spawnMax[a] ? o->speed : 0.f;
+  }
+  uint32_t seed = _syParticlesHash((uint32_t)p->generation);
+  _syParticlesRespawnKernel(p->x, p->y, p->z, p->vx, p->vy, p->vz, p->age,
+                            p->lifetime, begin, end, o->spawnMin, o->spawnMax,
+                            speed, o->minLifetime, o->maxLifetime, seed);
+  if (o->force != NULL) {
+    o->force(p, begin, end, p->dt, o->userData);
+  }
+  _syParticlesIntegrateKernel(p->x, p->y, p->z, p->vx, p->vy, p->vz, p->age,
+                              p->positions, begin, end, p->dt);
+}
+
+static inline void *_syParticlesWork(void *arg) {
+  _syParticlesWorker *w = (_syParticlesWorker *)arg;
+  syParticles *p = w->p;
+  uint64_t seen = 0;
+  while (true) {
+    pthread_mutex_lock(&p->mutex);
+    while (!p->quit && p->generation == seen) {
+      pthread_cond_wait(&p->start, &p->mutex);
+    }
+    if (p->quit) {
+      pthread_mutex_unlock(&p->mutex);
+      break;
+    }
+    seen = p->generation;
+    pthread_mutex_unlock(&p->mutex);
+
+    _syParticlesUpdateRange(p, w->index);
+
+    pthread_mutex_lock(&p->mutex);
+    if (--p->pending == 0) {
+      pthread_cond_signal(&p->done);
+    }
+    pthread_mutex_unlock(&p->mutex);
+  }
+  free(w);
+  return NULL;
+}
+
+static inline bool syParticlesInit(syParticles *p,
+                                   const syParticlesOptions *opts) {
+  p->opts = *opts;
+  p->count = opts->count;
+  float **arrays[] = {&p->x,  &p->y,  &p->z,        &p->vx,       &p->vy,
+                      &p->vz, &p->age, &p->lifetime, &p->positions};
+  const size_t numArrays = sizeof(arrays) / sizeof(arrays[0]);
+  bool allocated = true;
+  for (size_t i = 0; i < numArrays; i++) {
+    size_t n = arrays[i] == &p->positions ? p->count * 3 : p->count;
+    *arrays[i] = (float *)_syParticlesAlloc(sizeof(float) * n);
+    allocated = allocated && *arrays[i] != NULL;
+  }
+  if (!allocated) {
+    fprintf(stderr, "%s(): Could not allocate %zu particles\n", __func__,
+            p->count);
+    for (size_t i = 0; i < numArrays; i++) {
+      free(*arrays[i]);
+      *arrays[i] = NULL;
+    }
+    return false;
+  }
+
+  long numProcessors = sysconf(_SC_NPROCESSORS_ONLN);
+  p->numThreads = opts->numThreads > 0 ? opts->numThreads
+                  : numProcessors > 0  ? (size_t)numProcessors
+                                       : 1;
+  p->threads = (pthread_t *)calloc(p->numThreads, sizeof(pthread_t));
+  pthread_mutex_init(&p->mutex, NULL);
+  pthread_cond_init(&p->start, NULL);
+  pthread_cond_init(&p->done, NULL);
+  p->generation = 0;
+  p->pending = 0;
+  p->quit = false;
+  // Workers that could not be started are left out, and their share of the
+  // particles goes to the others. Without any, the calling thread does all.
+  size_t started = 1;
+  for (size_t i = 1; p->threads != NULL && i < p->numThreads; i++) {
+    _syParticlesWorker *w =
+        (_syParticlesWorker *)calloc(1, sizeof(_syParticlesWorker));
+    if (w == NULL) {
+      break;
+    }
+    w->p = p;
+    w->index = i;
+    if (pthread_create(&p->threads[i], NULL, _syParticlesWork, w) != 0) {
+      free(w);
+      break;
+    }
+    started++;
+  }
+  if (started < p->numThreads) {
+    fprintf(stderr, "%s(): Started %zu of %zu threads\n", __func__, started,
+            p->numThreads);
+    p->numThreads = started;
+  }
+  return true;
+}
+
+static inline void syParticlesUpdate(syParticles *p, float dt) {
+  pthread_mutex_lock(&p->mutex);
+  p->dt = dt;
+  p->generation++;
+  p->pending = p->numThreads - 1;
+  pthread_cond_broadcast(&p->start);
+  pthread_mutex_unlock(&p->mutex);
+
+  _syParticlesUpdateRange(p, 0);
+
+  pthread_mutex_lock(&p->mutex);
+  while (p->pending > 0) {
+    pthread_cond_wait(&p->done, &p->mutex);
+  }
+  pthread_mutex_unlock(&p->mutex);
+}
+
+static inline void syParticlesDestroy(syParticles *p) {
+  pthread_mutex_lock(&p->mutex);
+  p->quit = true;
+  pthread_cond_broadcast(&p->start);
+  pthread_mutex_unlock(&p->mutex);
+  for (size_t i = 1; i < p->numThreads; i++) {
+    pthread_join(p->threads[i], NULL);
+  }
+  pthread_mutex_destroy(&p->mutex);
+  pthread_cond_destroy(&p->start);
+  pthread_cond_destroy(&p->done);
+  free(p->threads);
+  float *arrays[] = {p->x,  p->y,  p->z,   p->vx,       p->vy,
+                     p->vz, p->age, p->lifetime, p->positions};
+  for (size_t i = 0; i < sizeof(arrays) / sizeof(arrays[0]); i++) {
+    free(arrays[i]);
+  }
+}
+
+#endif  // _SOYA_PARTICLES_H
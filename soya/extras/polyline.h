@@ -1,6 +1,8 @@
 #ifndef _SOYA_POLYLINE_H
 #define _SOYA_POLYLINE_H
 
+#include <stdint.h>
+
 #include <soya/lib/vec.h>
 #include <soya/lib/math.h>
 #include <cglm/struct.h>
@@ -18,10 +20,16 @@ typedef struct syPl {
   vec3s *data;
   /** Cumulative lengths. */
   syVec(float) lengths;
+  /** Incremented by @ref syPlUpdate, so that caches can detect changes. */
+  uint64_t version;
 } syPl;
 
-/** @since 0.2.0 */
+/**
+ * Recomputes the cumulative lengths. Call after modifying vertices directly.
+ * @since 0.2.0
+ * */
 static inline void syPlUpdate(syPl *pl) {
+  pl->version++;
   float length = 0;
   pl->lengths.data[0] = 0;
   for (size_t i = 1; i < pl->len; i++) {
@@ -41,6 +49,7 @@ static inline void syPlAddVertex(syPl *pl, vec3s v) {
 static inline void syPlInit(syPl *pl) {
   pl->len = 0;
   pl->cap = 16;
+  pl->version = 0;
   pl->data = calloc(pl->cap, sizeof(vec3s));
   syVecInit(pl->lengths, float);
 }
@@ -0,0 +1,322 @@
+/**
+ * @file polylinemesh.h
+ *
+ * Draws `syPl` polylines as screen-space ribbons of any width. Each segment is
+ * one instance of a small template mesh that the vertex shader places between
+ * the segment's end points, joined to its neighbours with miter or round
+ * joins. The points are uploaded once and kept on the GPU until a polyline
+ * changes.
+ * */
+#ifndef _SOYA_POLYLINEMESH_H
+#define _SOYA_POLYLINEMESH_H
+
+#include <math.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <soya/lib/sl.h>
+#include <soya/lib/vec.h>
+#include <soya/core/gl.h>
+#include <soya/core/app.h>
+#include <soya/core/shader.h>
+#include <soya/core/defaultshaders.h>
+#include <soya/extras/polyline.h>
+#include <soya/glad/glad.h>
+
+#include <cglm/struct.h>
+
+// Number of triangles in each round join
+#define SY_PL_MESH_ROUND_SEGMENTS 12
+
+// Miters longer than this many half widths are shortened to it, so that sharp
+// corners do not spike out.
+#define SY_PL_MESH_MITER_LIMIT 4.0
+
+/**
+ * How consecutive segments are joined. Polyline ends get butt caps with miter
+ * joins and round caps with round joins.
+ * */
+typedef enum syPlJoin {
+  SY_PL_JOIN_MITER,
+  SY_PL_JOIN_ROUND,
+} syPlJoin;
+
+// Inputs:
+// - location 0: vec4 template vertex. x selects the segment's start (0) or end
+//   (1) point, y and z are offsets along the segment's normal and direction in
+//   half widths and w is 1 for vertices of round joins.
+// - locations 1-4, per instance: the point before the segment, its two end
+//   points and the point after it. The neighbours equal the end points at the
+//   ends of a polyline.
+//
+// Uniforms:
+// - mat4 modelViewProjectionMatrix
+// - float width, in pixels
+// - int join, a `syPlJoin`
+// - vec4 color
+// - the frame uniforms, for the resolution
+static const char *SY_PL_MESH_VERTEX_SHADER =
+    "#version 430 core\n"
+    SYSL_FRAME_UNIFORMS
+    "layout (location = 0) in vec4 aTemplate;\n"
+    "layout (location = 1) in vec3 aPrev;\n"
+    "layout (location = 2) in vec3 aStart;\n"
+    "layout (location = 3) in vec3 aEnd;\n"
+    "layout (location = 4) in vec3 aNext;\n"
+    "uniform mat4 modelViewProjectionMatrix;\n"
+    "uniform float width;\n"
+    "uniform int join;\n"
+    "uniform vec4 color;\n"
+    "out vec4 vColor;\n"
+    "out vec4 vPos;\n"
+    "vec2 toScreen(vec4 clip) {\n"
+    "  return clip.xy / clip.w * 0.5 * syResolution;\n"
+    "}\n"
+    "vec2 direction(vec2 from, vec2 to, vec2 fallback) {\n"
+    "  vec2 d = to - from;\n"
+    "  return dot(d, d) > 1e-12 ? normalize(d) : fallback;\n"
+    "}\n"
+    "void main() {\n"
+    "  vec4 start = modelViewProjectionMatrix * vec4(aStart, 1.0);\n"
+    "  vec4 end = modelViewProjectionMatrix * vec4(aEnd, 1.0);\n"
+    "  vec2 a = toScreen(start);\n"
+    "  vec2 b = toScreen(end);\n"
+    "  vec2 dir = direction(a, b, vec2(1.0, 0.0));\n"
+    "  vec2 normal = vec2(-dir.y, dir.x);\n"
+    "  bool atEnd = aTemplate.x > 0.5;\n"
+    "  float halfWidth = width * 0.5;\n"
+    "  vec2 offset;\n"
+    "  if (aTemplate.w > 0.5) {\n"
+    // Round joins are drawn at the end of every segment, and at the start of
+    // the first segment of a polyline as its cap.
+    "    bool first = aPrev == aStart;\n"
+    "    float scale = atEnd || first ? halfWidth : 0.0;\n"
+    "    offset = (normal * aTemplate.y + dir * aTemplate.z) * scale;\n"
+    "  } else if (join == 0) {\n"
+    // Miter along the mean of this and the neighbouring segment's directions
+    "    vec2 other = atEnd\n"
+    "        ? direction(b, toScreen(modelViewProjectionMatrix *\n"
+    "                                vec4(aNext, 1.0)), dir)\n"
+    "        : direction(toScreen(modelViewProjectionMatrix *\n"
+    "                             vec4(aPrev, 1.0)), a, dir);\n"
+    "    vec2 tangent = direction(vec2(0.0), dir + other, dir);\n"
+    "    vec2 miter = vec2(-tangent.y, tangent.x);\n"
+    "    float len = halfWidth / max(dot(miter, normal), 1e-4);\n"
+    "    len = min(len, halfWidth * "
+    SYSL_STRINGIFY(SY_PL_MESH_MITER_LIMIT) ");\n"
+    "    offset = miter * len * aTemplate.y;\n"
+    "  } else {\n"
+    "    offset = normal * halfWidth * aTemplate.y;\n"
+    "  }\n"
+    "  vec4 clip = atEnd ? end : start;\n"
+    "  clip.xy += offset / (0.5 * syResolution) * clip.w;\n"
+    "  gl_Position = clip;\n"
+    "  vPos = clip;\n"
+    "  vColor = color;\n"
+    "}\n\0";
+
+// Layout of the commands read by `glMultiDrawArraysIndirect`.
+typedef struct syDrawArraysIndirectCommand {
+  uint32_t count, instanceCount, first, baseInstance;
+} syDrawArraysIndirectCommand;
+
+// State of a polyline when it was last uploaded
+typedef struct syPlMeshEntry {
+  const vec3s *data;
+  size_t len;
+  uint64_t version;
+} syPlMeshEntry;
+
+/**
+ * GPU copy of a set of polylines, drawn with one multi-draw call. Each
+ * polyline's points are stored with its first and last point repeated, so
+ * that every segment reads its end points and neighbours from four
+ * consecutive points, starting at the segment's instance.
+ *
+ * @sa syDrawPolylines
+ * */
+typedef struct syPlMesh {
+  GLuint vao, templateVbo, pointsVbo, commandsBuffer;
+  syShader shader;
+  syPlJoin join;
+  GLsizei numTemplateVertices;
+  syVec(syPlMeshEntry) entries;
+  syVec(vec3s) points;
+  syVec(syDrawArraysIndirectCommand) commands;
+} syPlMesh;
+
+#define SY_PL_MESH_MAX_TEMPLATE_VERTICES (6 + SY_PL_MESH_ROUND_SEGMENTS * 3 * 2)
+
+// Writes the vertices of the segment template for `join` to `out`, which holds
+// room for `SY_PL_MESH_MAX_TEMPLATE_VERTICES` vertices, and @returns their
+// number.
+
+static inline GLsizei syPlMeshTemplate(syPlJoin join, vec4s *out) {
+  static const float quad[6][2] = {{0, -1}, {1, -1}, {1, 1},
+                                   {0, -1}, {1, 1},  {0, 1}};
+  GLsizei n = 0;
+  for (int i = 0; i < 6; i++) {
+    out[n++] = (vec4s){{quad[i][0], quad[i][1], 0, 0}};
+  }
+  if (join != SY_PL_JOIN_ROUND) {
+    return n;
+  }
+  for (int end = 0; end < 2; end++) {
+    for (int i = 0; i < SY_PL_MESH_ROUND_SEGMENTS; i++) {
+      float a0 = (float)i / SY_PL_MESH_ROUND_SEGMENTS * (float)GLM_PI * 2.f;
+      float a1 = (float)(i + 1) / SY_PL_MESH_ROUND_SEGMENTS * (float)GLM_PI *
+                 2.f;
+      out[n++] = (vec4s){{(float)end, 0, 0, 1}};
+      out[n++] = (vec4s){{(float)end, sinf(a0), cosf(a0), 1}};
+      out[n++] = (vec4s){{(float)end, sinf(a1), cosf(a1), 1}};
+    }
+  }
+  return n;
+}
+
+static inline void syPlMeshInit(syGlState *s, syPlMesh *m,
+                                syPlJoin join) {
+  *m = (syPlMesh){0};
+  m->join = join;
+  syVecInit(m->entries, syPlMeshEntry);
+  syVecInit(m->points, vec3s);
+  syVecInit(m->commands, syDrawArraysIndirectCommand);
+
+  m->shader = syShaderProgramLoadFromSource(SY_DEFAULT_FRAGMENT_SHADER,
+                                            SY_PL_MESH_VERTEX_SHADER);
+
+  GLint prevVertexArray = 0, prevArrayBuffer = 0;
+  glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &prevVertexArray);
+  glGetIntegerv(GL_ARRAY_BUFFER_BINDING, &prevArrayBuffer);
+  glGenVertexArrays(1, &m->vao);
+  glGenBuffers(1, &m->templateVbo);
+  glGenBuffers(1, &m->pointsVbo);
+  glGenBuffers(1, &m->commandsBuffer);
+  glBindVertexArray(m->vao);
+
+  vec4s vertices[SY_PL_MESH_MAX_TEMPLATE_VERTICES];
+  m->numTemplateVertices = syPlMeshTemplate(join, vertices);
+  syWriteBuffer(s, GL_ARRAY_BUFFER, m->templateVbo,
+                (GLsizeiptr)(sizeof(vec4s) * (size_t)m->numTemplateVertices),
+                vertices, GL_STATIC_DRAW);
+  syVertexAttribute4f(0);
+
+  glBindBuffer(GL_ARRAY_BUFFER, m->pointsVbo);
+  for (GLuint i = 0; i < 4; i++) {
+    syVertexAttribute3fAt(1 + i, (GLintptr)(sizeof(vec3s) * i));
+    glVertexAttribDivisor(1 + i, 1);
+  }
+  glBindVertexArray((GLuint)prevVertexArray);
+  glBindBuffer(GL_ARRAY_BUFFER, (GLuint)prevArrayBuffer);
+}
+
+// @returns `true` if `polylines` differ from the ones last uploaded to `m`.
+static inline bool syPlMeshChanged(const syPlMesh *m, const syPl *polylines,
+                                   size_t n) {
+  if (m->entries.len != n) {
+    return true;
+  }
+  for (size_t i = 0; i < n; i++) {
+    const syPlMeshEntry *e = &m->entries.data[i];
+    if (e->data != polylines[i].data || e->len != polylines[i].len ||
+        e->version != polylines[i].version) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * Uploads the points of `n` polylines, unless they are unchanged since the
+ * last upload. Polylines with fewer than 2 points are skipped.
+ * */
+static inline void syPlMeshUpload(syGlState *s, syPlMesh *m,
+                                  const syPl *polylines, size_t n) {
+  if (!syPlMeshChanged(m, polylines, n)) {
+    return;
+  }
+  m->entries.len = 0;
+  m->points.len = 0;
+  m->commands.len = 0;
+  for (size_t i = 0; i < n; i++) {
+    const syPl *pl = &polylines[i];
+    syPlMeshEntry e = {pl->data, pl->len, pl->version};
+    syVecPush(m->entries, e);
+    if (pl->len < 2) {
+      continue;
+    }
+    syDrawArraysIndirectCommand command = {
+        .count = (uint32_t)m->numTemplateVertices,
+        .instanceCount = (uint32_t)(pl->len - 1),
+        .first = 0,
+        .baseInstance = (uint32_t)m->points.len};
+    syVecPush(m->commands, command);
+    syVecPush(m->points, pl->data[0]);
+    syVecPushArr(m->points, pl->data, pl->len);
+    syVecPush(m->points, pl->data[pl->len - 1]);
+  }
+  GLint prevArrayBuffer = 0;
+  glGetIntegerv(GL_ARRAY_BUFFER_BINDING, &prevArrayBuffer);
+  syWriteBuffer(s, GL_ARRAY_BUFFER, m->pointsVbo,
+                (GLsizeiptr)(sizeof(vec3s) * m->points.len), m->points.data,
+                GL_STATIC_DRAW);
+  glBindBuffer(GL_ARRAY_BUFFER, (GLuint)prevArrayBuffer);
+  syWriteBuffer(s, GL_DRAW_INDIRECT_BUFFER, m->commandsBuffer,
+                (GLsizeiptr)(sizeof(syDrawArraysIndirectCommand) *
+                             m->commands.len),
+                m->commands.data, GL_STATIC_DRAW);
+}
+
+/**
+ * Draws `n` polylines `width` pixels wide in the current color with the
+ * current transformations. The points are only uploaded again when a polyline
+ * was changed, so call `syPlUpdate` after modifying a polyline's vertices
+ * directly. Widths are relative to the window's resolution from the frame
+ * uniforms.
+ * */
+static inline void syDrawPolylines(syApp *app, syPlMesh *m,
+                                   const syPl *polylines, size_t n,
+                                   float width) {
+  syRenderer *r = &app->renderer;
+  syRendererFlush(r);
+  syPlMeshUpload(&r->gl, m, polylines, n);
+  if (m->commands.len == 0) {
+    return;
+  }
+  syGlUseProgram(&r->gl, m->shader);
+  syGlBindVertexArray(&r->gl, m->vao);
+  syGlBindBuffer(&r->gl, GL_DRAW_INDIRECT_BUFFER, m->commandsBuffer);
+  syRendererSetShaderUniforms(r, m->shader);
+  syGlUniform1f(&r->gl, m->shader, "width", width);
+  syGlUniform1i(&r->gl, m->shader, "join", (int)m->join);
+  syGlUniform4fv(&r->gl, m->shader, "color", r->color);
+  glMultiDrawArraysIndirect(GL_TRIANGLES, NULL, (GLsizei)m->commands.len, 0);
+  r->gl.stats.drawCalls++;
+  SY_VEC_FOREACH(m->commands, i) {
+    const syDrawArraysIndirectCommand *c = &m->commands.data[i];
+    r->gl.stats.vertices += (uint64_t)c->count * c->instanceCount;
+    r->gl.stats.primitives += c->count / 3 * c->instanceCount;
+  }
+  syGlUseProgram(&r->gl, r->shader);
+}
+
+/**
+ * Draws a single polyline. @see syDrawPolylines
+ * */
+static inline void syDrawPolyline(syApp *app, syPlMesh *m, const syPl *pl,
+                                  float width) {
+  syDrawPolylines(app, m, pl, 1, width);
+}
+
+static inline void syPlMeshDestroy(syPlMesh *m) {
+  syShaderDestroy(m->shader);
+  glDeleteVertexArrays(1, &m->vao);
+  glDeleteBuffers(1, &m->templateVbo);
+  glDeleteBuffers(1, &m->pointsVbo);
+  glDeleteBuffers(1, &m->commandsBuffer);
+  syVecDestroy(m->entries);
+  syVecDestroy(m->points);
+  syVecDestroy(m->commands);
+}
+
+#endif  // _SOYA_POLYLINEMESH_H
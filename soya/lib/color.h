@@ -9,6 +9,8 @@
 #pragma once
 
 #include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
 #include <math.h>
 
 /**
@@ -49,6 +51,18 @@ typedef struct syColor {
   float a;
 } syColor;
 
+/**
+ * A color packed into 8 bits per channel, a quarter of the size of a
+ * @ref syColor. Arrays of it can be passed to the draw functions as normalized
+ * `GL_UNSIGNED_BYTE` vertex colors.
+ *
+ * @sa syColorTo8, syColor8ToColor
+ * @since 0.4.0
+ **/
+typedef struct syColor8 {
+  uint8_t r, g, b, a;
+} syColor8;
+
 #define SY_BLACK (syColor){{0}, {0}, {0}, 1}
 #define SY_BLUE (syColor){{0}, {0}, {1}, 1}
 #define SY_CYAN (syColor){{0}, {1}, {1}, 1}
@@ -160,6 +174,47 @@ static inline syColor syWithAlpha(syColor c, float a) {
   return syRgb(c.r, c.g, c.b, a);
 }
 
+/**
+ * @returns `v` clamped to [0-1] and scaled to [0-255], rounded to the nearest
+ * integer.
+ * @since 0.4.0
+ * */
+static inline uint8_t syUnitToByte(float v) {
+  v = v < 0.f ? 0.f : v > 1.f ? 1.f : v;
+  return (uint8_t)(v * 255.f + 0.5f);
+}
+
+/**
+ * @returns `c` packed into 8 bits per channel. Components are clamped to [0-1].
+ * @sa syColor8ToColor
+ * @since 0.4.0
+ * */
+static inline syColor8 syColorTo8(syColor c) {
+  return (syColor8){syUnitToByte(c.r), syUnitToByte(c.g), syUnitToByte(c.b),
+                    syUnitToByte(c.a)};
+}
+
+/**
+ * @returns `c` unpacked into floats in [0-1].
+ * @sa syColorTo8
+ * @since 0.4.0
+ * */
+static inline syColor syColor8ToColor(syColor8 c) {
+  const float s = 1.f / 255.f;
+  return syRgb(c.r * s, c.g * s, c.b * s, c.a * s);
+}
+
+/**
+ * Packs `n` colors given as 4 floats each into `out`.
+ * @since 0.4.0
+ * */
+static inline void syColorsTo8(const float *colors, syColor8 *out, size_t n) {
+  uint8_t *bytes = (uint8_t *)out;
+  for (size_t i = 0; i < n * 4; i++) {
+    bytes[i] = syUnitToByte(colors[i]);
+  }
+}
+
 /**
  * Prints the values of the color's 4 components.
  * @param c The color to be printed.
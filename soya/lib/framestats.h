@@ -0,0 +1,295 @@
+/**
+ * @file framestats.h
+ *
+ * Rolling statistics of frame times, kept in a ring buffer of the most recent
+ * frames, with an optional periodic report to stdout or a CSV file.
+ * */
+
+#pragma once
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+
+/**
+ * Number of frames the statistics are computed over.
+ * @since 0.4.0
+ * */
+#ifndef SY_FRAME_STATS_CAPACITY
+#define SY_FRAME_STATS_CAPACITY 256
+#endif
+
+/**
+ * CPU time in seconds spent in each part of a frame.
+ * @since 0.4.0
+ * */
+typedef struct syFrameTimes {
+  /** Running `loop()` and submitting its draws */
+  double loop;
+  /** Swapping buffers, which includes waiting for vsync */
+  double swap;
+  /** Polling events, which includes running the input callbacks */
+  double poll;
+  /** Whole frame */
+  double total;
+} syFrameTimes;
+
+/**
+ * Distribution of one of the @ref syFrameTimes over the recorded frames, in
+ * seconds.
+ * @since 0.4.0
+ * */
+typedef struct syFrameTimeSummary {
+  double min, mean, p50, p95, p99, max;
+} syFrameTimeSummary;
+
+/**
+ * Frame times of the last `SY_FRAME_STATS_CAPACITY` frames and their
+ * summaries. The summaries are only computed when they are needed, by
+ * @ref syFrameStatsUpdate. A frame taking longer than `hitchFactor` times the
+ * median frame counts as a hitch.
+ *
+ * @sa syFrameStatsInit, syFrameStatsPush, syFrameStatsUpdate
+ * @since 0.4.0
+ * */
+typedef struct syFrameStats {
+  syFrameTimes frames[SY_FRAME_STATS_CAPACITY];
+  bool hitches[SY_FRAME_STATS_CAPACITY];
+  size_t len, next;
+  uint64_t numFrames;
+  /** Summaries as of the last @ref syFrameStatsUpdate */
+  syFrameTimeSummary loop, swap, poll, total;
+  /** Whether frames were pushed since the summaries were computed */
+  bool dirty;
+  /** Default: 2 */
+  double hitchFactor;
+  /** Hitches among the recorded frames */
+  size_t recentHitches;
+  /** Hitches since the statistics were initialized */
+  uint64_t numHitches;
+  /** Seconds between reports, or 0 for no reports. Default: 0 */
+  double reportInterval;
+  /**
+   * File reports are appended to as CSV rows, or `NULL` to print them to
+   * stdout. Default: `NULL`
+   * */
+  const char *csvPath;
+  FILE *csv;
+  double lastReport;
+  /** Scratch space for sorting and selecting frame times */
+  double sorted[SY_FRAME_STATS_CAPACITY];
+} syFrameStats;
+
+/**
+ * @since 0.4.0
+ * */
+static inline void syFrameStatsInit(syFrameStats *s) {
+  memset(s, 0, sizeof(*s));
+  s->hitchFactor = 2;
+  s->lastReport = -1;
+}
+
+static inline int syFrameStatsCompare(const void *a, const void *b) {
+  double x = *(const double *)a, y = *(const double *)b;
+  return (x > y) - (x < y);
+}
+
+/**
+ * @returns the summary of the frame times at byte offset `field` within
+ * @ref syFrameTimes.
+ * @since 0.4.0
+ * */
+static inline syFrameTimeSummary syFrameStatsSummarize(syFrameStats *s,
+                                                       size_t field) {
+  syFrameTimeSummary summary = {0};
+  size_t n = s->len;
+  if (n == 0) {
+    return summary;
+  }
+  double sum = 0;
+  for (size_t i = 0; i < n; i++) {
+    double t;
+    memcpy(&t, (const char *)&s->frames[i] + field, sizeof(t));
+    s->sorted[i] = t;
+    sum += t;
+  }
+  qsort(s->sorted, n, sizeof(double), syFrameStatsCompare);
+  // Nearest-rank percentiles
+  summary.min = s->sorted[0];
+  summary.p50 = s->sorted[(n * 50 + 99) / 100 - 1];
+  summary.p95 = s->sorted[(n * 95 + 99) / 100 - 1];
+  summary.p99 = s->sorted[(n * 99 + 99) / 100 - 1];
+  summary.max = s->sorted[n - 1];
+  summary.mean = sum / (double)n;
+  return summary;
+}
+
+/**
+ * @returns the `k`th smallest of the `n` values in `v`, reordering them.
+ * */
+static inline double syFrameStatsSelect(double *v, size_t n, size_t k) {
+  ptrdiff_t lo = 0, hi = (ptrdiff_t)n - 1, target = (ptrdiff_t)k;
+  while (lo < hi) {
+    double pivot = v[lo + (hi - lo) / 2];
+    ptrdiff_t i = lo, j = hi;
+    while (i <= j) {
+      while (v[i] < pivot) {
+        i++;
+      }
+      while (v[j] > pivot) {
+        j--;
+      }
+      if (i <= j) {
+        double t = v[i];
+        v[i++] = v[j];
+        v[j--] = t;
+      }
+    }
+    if (target <= j) {
+      hi = j;
+    } else if (target >= i) {
+      lo = i;
+    } else {
+      break;
+    }
+  }
+  return v[k];
+}
+
+/**
+ * @returns the nearest-rank median of the recorded frames' total times, the
+ * same as `total.p50` after @ref syFrameStatsUpdate, without sorting them.
+ * @since 0.4.0
+ * */
+static inline double syFrameStatsMedian(syFrameStats *s) {
+  size_t n = s->len;
+  if (n == 0) {
+    return 0;
+  }
+  for (size_t i = 0; i < n; i++) {
+    s->sorted[i] = s->frames[i].total;
+  }
+  return syFrameStatsSelect(s->sorted, n, (n * 50 + 99) / 100 - 1);
+}
+
+/**
+ * Computes the summaries if frames were pushed since they were last computed.
+ * Called before the summaries are reported or shown.
+ * @since 0.4.0
+ * */
+static inline void syFrameStatsUpdate(syFrameStats *s) {
+  if (!s->dirty) {
+    return;
+  }
+  s->loop = syFrameStatsSummarize(s, offsetof(syFrameTimes, loop));
+  s->swap = syFrameStatsSummarize(s, offsetof(syFrameTimes, swap));
+  s->poll = syFrameStatsSummarize(s, offsetof(syFrameTimes, poll));
+  s->total = syFrameStatsSummarize(s, offsetof(syFrameTimes, total));
+  s->dirty = false;
+}
+
+/**
+ * Writes the summaries as of the last @ref syFrameStatsUpdate to `f`, as a
+ * CSV row if `csv` is set.
+ * @since 0.4.0
+ * */
+static inline void syFrameStatsWrite(const syFrameStats *s, FILE *f,
+                                     bool csv) {
+  const syFrameTimeSummary *summaries[] = {&s->loop, &s->swap, &s->poll,
+                                           &s->total};
+  const char *names[] = {"loop", "swap", "poll", "total"};
+  if (csv) {
+    fprintf(f, "%llu", (unsigned long long)s->numFrames);
+    for (size_t i = 0; i < 4; i++) {
+      const syFrameTimeSummary *m = summaries[i];
+      fprintf(f, ",%.4f,%.4f,%.4f,%.4f,%.4f", m->min * 1e3, m->mean * 1e3,
+              m->p50 * 1e3, m->p95 * 1e3, m->p99 * 1e3);
+    }
+    fprintf(f, ",%zu,%llu\n", s->recentHitches,
+            (unsigned long long)s->numHitches);
+    return;
+  }
+  fprintf(f, "Frame %llu (ms, min/mean/p50/p95/p99):",
+          (unsigned long long)s->numFrames);
+  for (size_t i = 0; i < 4; i++) {
+    const syFrameTimeSummary *m = summaries[i];
+    fprintf(f, " %s %.2f/%.2f/%.2f/%.2f/%.2f", names[i], m->min * 1e3,
+            m->mean * 1e3, m->p50 * 1e3, m->p95 * 1e3, m->p99 * 1e3);
+  }
+  fprintf(f, ", hitches %zu (%llu total)\n", s->recentHitches,
+          (unsigned long long)s->numHitches);
+}
+
+/**
+ * Reports the current summaries if `reportInterval` seconds have passed since
+ * the last report at time `now`.
+ * @since 0.4.0
+ * */
+static inline void syFrameStatsReport(syFrameStats *s, double now) {
+  if (s->reportInterval <= 0 ||
+      (s->lastReport >= 0 && now - s->lastReport < s->reportInterval)) {
+    return;
+  }
+  s->lastReport = now;
+  syFrameStatsUpdate(s);
+  if (s->csvPath == NULL) {
+    syFrameStatsWrite(s, stdout, false);
+    return;
+  }
+  if (s->csv == NULL) {
+    s->csv = fopen(s->csvPath, "w");
+    if (s->csv == NULL) {
+      fprintf(stderr, "%s(): Could not open %s\n", __func__, s->csvPath);
+      s->reportInterval = 0;
+      return;
+    }
+    fprintf(s->csv, "frame");
+    const char *names[] = {"loop", "swap", "poll", "total"};
+    const char *stats[] = {"min", "mean", "p50", "p95", "p99"};
+    for (size_t i = 0; i < 4; i++) {
+      for (size_t j = 0; j < 5; j++) {
+        fprintf(s->csv, ",%s_%s_ms", names[i], stats[j]);
+      }
+    }
+    fprintf(s->csv, ",recent_hitches,hitches\n");
+  }
+  syFrameStatsWrite(s, s->csv, true);
+}
+
+/**
+ * Records the times of a frame that ended at time `now` in seconds, updates
+ * the hitch counts, and reports the summaries if it is time to.
+ * @since 0.4.0
+ * */
+static inline void syFrameStatsPush(syFrameStats *s, syFrameTimes times,
+                                    double now) {
+  double median = syFrameStatsMedian(s);
+  bool hitch = median > 0 && times.total > median * s->hitchFactor;
+  if (s->len == SY_FRAME_STATS_CAPACITY) {
+    s->recentHitches -= s->hitches[s->next];
+  } else {
+    s->len++;
+  }
+  s->frames[s->next] = times;
+  s->hitches[s->next] = hitch;
+  s->next = (s->next + 1) % SY_FRAME_STATS_CAPACITY;
+  s->numFrames++;
+  s->recentHitches += hitch;
+  s->numHitches += hitch;
+  s->dirty = true;
+  syFrameStatsReport(s, now);
+}
+
+/**
+ * Closes the CSV file.
+ * @since 0.4.0
+ * */
+static inline void syFrameStatsDestroy(syFrameStats *s) {
+  if (s->csv != NULL) {
+    fclose(s->csv);
+    s->csv = NULL;
+  }
+}
@@ -6,3 +6,4 @@
 #include <soya/lib/math.h>
 #include <soya/lib/color.h>
 #include <soya/lib/preprocessor.h>
+#include <soya/lib/framestats.h>
@@ -94,6 +94,38 @@
  * */
 #define SYSL_UNIFORM_VEC4(identifier) SYSL_UNIFORM(vec4, identifier)
 
+/**
+ * Uniform buffer binding point of @ref SYSL_FRAME_UNIFORMS.
+ * @since 0.4.0
+ * */
+#define SYSL_FRAME_UNIFORMS_BINDING 0
+
+#define SYSL_STRINGIFY_(x) #x
+#define SYSL_STRINGIFY(x) SYSL_STRINGIFY_(x)
+
+/**
+ * Declaration of the std140 uniform block that Soya updates once per frame.
+ * Its members are accessible without a block name:
+ * - `mat4 syView`
+ * - `mat4 syProjection`
+ * - `mat4 syViewProjection`
+ * - `vec2 syResolution`, in pixels
+ * - `float syTime`, in seconds
+ * - `uint syFrameNum`
+ * @since 0.4.0
+ * */
+#define SYSL_FRAME_UNIFORMS                                \
+  "layout (std140, binding = "                             \
+  SYSL_STRINGIFY(SYSL_FRAME_UNIFORMS_BINDING)              \
+  ") uniform syFrameUniforms {\n"                          \
+  "  mat4 syView;\n"                                       \
+  "  mat4 syProjection;\n"                                 \
+  "  mat4 syViewProjection;\n"                             \
+  "  vec2 syResolution;\n"                                 \
+  "  float syTime;\n"                                      \
+  "  uint syFrameNum;\n"                                   \
+  "};\n"
+
 /**
  * GLSL output declaration.
  * ```
@@ -79,6 +79,21 @@
     (v).len++;                                                         \
   } while (0)
 
+/**
+ * Grows the vector's capacity to hold at least `n` elements. The length and
+ * elements are unchanged.
+ * @param v The vector to grow
+ * @param n The number of elements to make room for
+ * @since 0.4.0
+ * */
+#define syVecReserve(v, n)                                         \
+  do {                                                             \
+    if ((v).cap < (n)) {                                           \
+      (v).data = realloc((v).data, (n) * sizeof((v).data[0]));     \
+      (v).cap = (n);                                               \
+    }                                                              \
+  } while (0)
+
 /**
  * Pushes 2 elements into the vector. The vector and all elements
  * must have the same type.
@@ -30,8 +30,13 @@ static inline bool syMainPostConfigure(syApp *app) {
   glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, app->glVersionMajor);
   glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, app->glVersionMinor);
   glfwWindowHint(GLFW_SAMPLES, 8);
+  glfwWindowHint(GLFW_CONTEXT_CREATION_API, app->contextApi);
+  if (app->headless) {
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+  }
 
-  printf("%s(): Creating %ix%i window\n", __func__, app->width, app->height);
+  printf("%s(): Creating %ix%i %swindow\n", __func__, app->width, app->height,
+         app->headless ? "hidden " : "");
   app->window =
       glfwCreateWindow(app->width, app->height, app->title, NULL, NULL);
 
@@ -42,13 +47,33 @@ static inline bool syMainPostConfigure(syApp *app) {
 
   printf("%s(): calling glfwMakeContextCurrent()\n", __func__);
   glfwMakeContextCurrent(app->window);
-  glfwSwapInterval(1);
+  // Headless apps and apps on the offline clock render as fast as possible
+  // instead of at the refresh rate
+  glfwSwapInterval(app->headless || app->offlineFps > 0 ? 0 : 1);
   gladLoadGL();
   glViewport(0, 0, app->width, app->height);
   glEnable(GL_DEPTH_TEST);
   return true;
 }
 
+// Creates the headless target and makes it stand in for the window's
+// framebuffer.
+static inline void syMainBeginHeadless(syApp *app) {
+  printf("%s(): Rendering headless into a %ix%i framebuffer\n", __func__,
+         app->width, app->height);
+  app->headlessTarget = syFboCreate(&(syFboOptions){
+      .width = app->width,
+      .height = app->height,
+      .internalFormat = GL_RGBA8,
+      .format = GL_RGBA,
+      .type = GL_UNSIGNED_BYTE,
+      .depth = true,
+  });
+  app->renderer.defaultFramebuffer = app->headlessTarget.framebuffer;
+  syRendererBindTarget(&app->renderer, 0, app->renderer.defaultWidth,
+                       app->renderer.defaultHeight);
+}
+
 int main(void) {
 #ifdef _DEBUG
   printf("%s(): Configuration: DEBUG\n", __func__);
@@ -56,19 +81,31 @@ int main(void) {
   srand((unsigned)time(NULL));
   int success = -1;
 
+  syApp app = {0};
+  syAppPreConfigure(&app);
+  configure(&app);
+
   glfwSetErrorCallback(syOnError);
+#ifdef GLFW_PLATFORM_NULL
+  // Without a native context, headless apps need no display at all
+  if (app.headless && app.contextApi != GLFW_NATIVE_CONTEXT_API) {
+    glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL);
+  }
+#endif
   printf("%s(): calling glfwInit()\n", __func__);
   if (!glfwInit()) {
     return false;
   }
-
-  syApp app = {0};
-  syAppPreConfigure(&app);
-  configure(&app);
   if (!syMainPostConfigure(&app)) {
     return success;
   };
   syRendererInit(&app.renderer, app.width, app.height);
+  syFboPoolInit(&app.fboPool);
+  if (app.headless) {
+    syMainBeginHeadless(&app);
+  }
+  syProfilerInit(&app.profiler);
+  app.profiler.capturing = app.profileTracePath != NULL;
   printf("%s(): Setting GL_PACK_ALIGNMENT to 2\n", __func__);
   glPixelStorei(GL_PACK_ALIGNMENT, 2);
   setup(&app);
@@ -80,16 +117,54 @@ int main(void) {
   glfwSetCursorPosCallback(app.window, syOnMouseMoved);
   glfwSetScrollCallback(app.window, syOnScroll);
 
+  if (app.offlineFps > 0) {
+    printf("%s(): Using an offline clock at %i fps\n", __func__,
+           app.offlineFps);
+  }
   printf("%s(): Beginning main loop...\n", __func__);
   double prevTime = glfwGetTime();
-  while (!glfwWindowShouldClose(app.window)) {
+  while (!glfwWindowShouldClose(app.window) &&
+         (app.frameLimit == 0 || app.frameNum < app.frameLimit)) {
+    syProfilerBeginFrame(&app.profiler, app.frameNum);
+    syRendererResetStats(&app.renderer);
+    if (syFboPoolBeginFrame(&app.fboPool)) {
+      syGlStateInvalidate(&app.renderer.gl);
+    }
+    double loopStart = glfwGetTime();
+    syProfileBegin(&app, "loop");
+    syUpdateFrameUniforms(&app);
     loop(&app);
-    glfwSwapBuffers(app.window);
+    syRendererSubmitCommandLists(&app.renderer);
+    syDrawHud(&app);
+    syRendererEndFrame(&app.renderer);
+    syProfileEnd(&app);
+    double swapStart = glfwGetTime();
+    syProfileBegin(&app, "swap");
+    if (!app.headless) {
+      glfwSwapBuffers(app.window);
+    }
+    syProfileEnd(&app);
+    double pollStart = glfwGetTime();
+    syProfileBegin(&app, "poll");
     glfwPollEvents();
+    syProfileEnd(&app);
+    double frameEnd = glfwGetTime();
+    syFrameStatsPush(&app.frameStats,
+                     (syFrameTimes){.loop = swapStart - loopStart,
+                                    .swap = pollStart - swapStart,
+                                    .poll = frameEnd - pollStart,
+                                    .total = frameEnd - loopStart},
+                     frameEnd);
     app.frameNum++;
-    app.time = glfwGetTime();
-    app.fps = 1.f / (float)(app.time - prevTime);
-    prevTime = app.time;
+    if (app.offlineFps > 0) {
+      // Derived from the frame number so that no rounding error accumulates
+      app.time = (double)app.frameNum / app.offlineFps;
+      app.fps = (float)app.offlineFps;
+    } else {
+      app.time = glfwGetTime();
+      app.fps = 1.f / (float)(app.time - prevTime);
+      prevTime = app.time;
+    }
   }
 
   printf("%s(): Main loop exited\n", __func__);
@@ -98,9 +173,19 @@ int main(void) {
     app.onExit();
   }
   printf("%s(): Cleaning up resources\n", __func__);
-  glDeleteBuffers(1, &app.renderer.vbo);
-  glDeleteBuffers(1, &app.renderer.cbo);
-  glDeleteBuffers(1, &app.renderer.ibo);
+  syFrameStatsDestroy(&app.frameStats);
+  if (app.profileTracePath != NULL &&
+      syProfileWriteTrace(&app, app.profileTracePath)) {
+    printf("%s(): Wrote profile trace to %s\n", __func__,
+           app.profileTracePath);
+  }
+  syProfilerDestroy(&app.profiler);
+  syHudDestroy(&app.hud);
+  syFboPoolDestroy(&app.fboPool);
+  if (app.headless) {
+    syDestroyFbo(&app, &app.headlessTarget);
+  }
+  syRendererDestroy(&app.renderer);
   glfwTerminate();
   return 0;
 }
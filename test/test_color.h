@@ -45,3 +45,36 @@ TEST(color_with_alpha) {
   }
   return (TestStatus){.result = TEST_SUCCESS};
 }
+
+TEST(color_pack) {
+  syColor8 c = syColorTo8(syRgb(0, 0.5, 1, 2));
+  EXPECT(c.r == 0);
+  EXPECT(c.g == 128);
+  EXPECT(c.b == 255);
+  EXPECT(c.a == 255);
+  EXPECT(syColorTo8(syRgb(-1, 0, 0, 0)).r == 0);
+
+  for (int i = 0; i < 256; i++) {
+    syColor8 p = {(uint8_t)i, (uint8_t)(255 - i), (uint8_t)i, 255};
+    syColor8 q = syColorTo8(syColor8ToColor(p));
+    EXPECT(p.r == q.r);
+    EXPECT(p.g == q.g);
+    EXPECT(p.b == q.b);
+    EXPECT(p.a == q.a);
+  }
+  return (TestStatus){.result = TEST_SUCCESS};
+}
+
+TEST(color_pack_array) {
+  syColor cols[] = {SY_RED, SY_CYAN, syRgb(0.2, 0.4, 0.6, 0.8)};
+  syColor8 packed[3];
+  syColorsTo8((const float *)cols, packed, 3);
+  for (size_t i = 0; i < 3; i++) {
+    syColor8 expected = syColorTo8(cols[i]);
+    EXPECT(packed[i].r == expected.r);
+    EXPECT(packed[i].g == expected.g);
+    EXPECT(packed[i].b == expected.b);
+    EXPECT(packed[i].a == expected.a);
+  }
+  return (TestStatus){.result = TEST_SUCCESS};
+}
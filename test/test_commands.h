@@ -0,0 +1,144 @@
+#pragma once
+
+#include "common.h"
+#include <soya/core/commands.h>
+
+// Records a stream command made with `program` and `renderState`
+static void commandsPush(syCommandBuffer *cb, GLuint program,
+                         uint32_t renderState, bool ordered) {
+  syCommand c = {.type = SY_COMMAND_STREAM,
+                 .program = program,
+                 .renderState = renderState,
+                 .vertices = SY_COMMAND_NO_DATA,
+                 .colors = SY_COMMAND_NO_DATA,
+                 .indices = SY_COMMAND_NO_DATA};
+  syCommandBufferPush(cb, &c, ordered);
+}
+
+TEST(commands_sort_stable) {
+  syCommandBuffer cb;
+  syCommandBufferInit(&cb);
+  for (int i = 0; i < 300; i++) {
+    commandsPush(&cb, i % 2 ? 2 : 1, 0, false);
+  }
+  const syCommandKey *keys = syCommandBufferSort(&cb);
+  for (size_t i = 0; i < 300; i++) {
+    EXPECT(cb.commands.data[keys[i].index].program == (i < 150 ? 1u : 2u));
+    EXPECT(i % 150 == 0 || keys[i].index > keys[i - 1].index);
+  }
+  // Equal keys keep their order. Only one byte differs, so the keys are sorted
+  // in a single pass and the result is left in the scratch space.
+  for (size_t i = 0; i < 300; i++) {
+    cb.keys.data[i] = (syCommandKey){(uint64_t)(i % 3) << 32, (uint32_t)i};
+  }
+  keys = syCommandBufferSort(&cb);
+  EXPECT(keys == cb.scratch.data);
+  for (size_t i = 0; i < 300; i++) {
+    EXPECT(keys[i].index % 3 == i / 100);
+    EXPECT(i % 100 == 0 || keys[i].index > keys[i - 1].index);
+  }
+  syCommandBufferDestroy(&cb);
+  return (TestStatus){.result = TEST_SUCCESS};
+}
+
+TEST(commands_sort_ordered) {
+  syCommandBuffer cb;
+  syCommandBufferInit(&cb);
+  commandsPush(&cb, 1, SY_RENDER_STATE_BLEND, false);
+  commandsPush(&cb, 3, 0, false);
+  commandsPush(&cb, 1, 0, true);
+  commandsPush(&cb, 2, 0, false);
+  commandsPush(&cb, 2, SY_RENDER_STATE_BLEND, false);
+  // Unordered commands by program, then ordered and blended commands in the
+  // order they were recorded in
+  const uint32_t expected[] = {3, 1, 0, 2, 4};
+  const syCommandKey *keys = syCommandBufferSort(&cb);
+  for (size_t i = 0; i < 5; i++) {
+    EXPECT(keys[i].index == expected[i]);
+  }
+  syCommandBufferDestroy(&cb);
+  return (TestStatus){.result = TEST_SUCCESS};
+}
+
+TEST(commands_sort_passes) {
+  syCommandBuffer cb;
+  syCommandBufferInit(&cb);
+  commandsPush(&cb, 2, 0, false);
+  commandsPush(&cb, 1, 0, false);
+  EXPECT(syCommandBufferBarrier(&cb));
+  commandsPush(&cb, 1, 0, false);
+  EXPECT(syCommandBufferBarrier(&cb));
+  // Empty passes are not counted
+  EXPECT(syCommandBufferBarrier(&cb));
+  EXPECT(cb.pass == 2);
+  commandsPush(&cb, 2, 0, false);
+  commandsPush(&cb, 1, 0, false);
+  // Commands are only reordered within their pass. The pass, program and
+  // sequence bytes differ, so the result is left in the scratch space.
+  const uint32_t expected[] = {1, 0, 2, 4, 3};
+  const syCommandKey *keys = syCommandBufferSort(&cb);
+  EXPECT(keys == cb.scratch.data);
+  for (size_t i = 0; i < 5; i++) {
+    EXPECT(keys[i].index == expected[i]);
+  }
+  syCommandBufferDestroy(&cb);
+  return (TestStatus){.result = TEST_SUCCESS};
+}
+
+TEST(commands_barrier_limit) {
+  syCommandBuffer cb;
+  syCommandBufferInit(&cb);
+  for (int i = 0; i < SY_COMMAND_MAX_PASSES - 1; i++) {
+    commandsPush(&cb, 1, 0, false);
+    EXPECT(syCommandBufferBarrier(&cb));
+  }
+  commandsPush(&cb, 1, 0, false);
+  EXPECT(!syCommandBufferBarrier(&cb));
+  syCommandBufferClear(&cb);
+  EXPECT(cb.pass == 0);
+  syCommandBufferDestroy(&cb);
+  return (TestStatus){.result = TEST_SUCCESS};
+}
+
+TEST(commands_sort_pools) {
+  syCommandBuffer cb;
+  syCommandBufferInit(&cb);
+  syMeshPool pools[2] = {{.vao = 2}, {.vao = 1}};
+  for (int i = 0; i < 4; i++) {
+    syCommand c = {.type = SY_COMMAND_POOL,
+                   .program = 1,
+                   .pool = &pools[i % 2],
+                   .vertices = SY_COMMAND_NO_DATA,
+                   .colors = SY_COMMAND_NO_DATA,
+                   .indices = SY_COMMAND_NO_DATA};
+    syCommandBufferPush(&cb, &c, false);
+  }
+  // Pool commands are sorted by the vertex array of their pool
+  const uint32_t expected[] = {1, 3, 0, 2};
+  const syCommandKey *keys = syCommandBufferSort(&cb);
+  for (size_t i = 0; i < 4; i++) {
+    EXPECT(keys[i].index == expected[i]);
+  }
+  syCommandBufferDestroy(&cb);
+  return (TestStatus){.result = TEST_SUCCESS};
+}
+
+TEST(commands_reserve_pass) {
+  syCommandBuffer cb;
+  syCommandBufferInit(&cb);
+  // A reserved pass is not skipped while it is empty
+  EXPECT(syCommandBufferReservePass(&cb) == 0);
+  EXPECT(syCommandBufferBarrier(&cb));
+  EXPECT(cb.pass == 1);
+  EXPECT(syCommandBufferBarrier(&cb));
+  EXPECT(cb.pass == 1);
+  // Keys pushed into an earlier pass are sorted before the current one
+  commandsPush(&cb, 1, 0, false);
+  syCommand c = {.type = SY_COMMAND_STREAM, .program = 2};
+  syCommandBufferPushKey(&cb, &c, false, 0, 7, 1);
+  const syCommandKey *keys = syCommandBufferSort(&cb);
+  EXPECT(keys[0].index == 7 && keys[0].buffer == 1);
+  EXPECT(keys[1].index == 0 && keys[1].buffer == 0);
+  syCommandBufferDestroy(&cb);
+  return (TestStatus){.result = TEST_SUCCESS};
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "common.h"
+#include <soya/lib/framestats.h>
+
+TEST(framestats_percentiles) {
+  syFrameStats s;
+  syFrameStatsInit(&s);
+  // Frames of 1 to 64 ms, pushed more than once around the ring buffer
+  for (int i = 0; i < 64 * 10; i++) {
+    double t = (double)(i % 64 + 1) / 1000;
+    syFrameStatsPush(&s, (syFrameTimes){.loop = t, .total = t}, 0);
+  }
+  EXPECT(s.len == SY_FRAME_STATS_CAPACITY);
+  EXPECT(syFrameStatsMedian(&s) == 0.032);
+  syFrameStatsUpdate(&s);
+  EXPECT(!s.dirty);
+  EXPECT(s.total.min == 0.001);
+  EXPECT(s.total.max == 0.064);
+  EXPECT(s.total.p50 == 0.032);
+  EXPECT(s.total.p95 == 0.061);
+  EXPECT(s.total.p99 == 0.064);
+  EXPECT(s.loop.mean == s.total.mean);
+  EXPECT(s.swap.max == 0);
+  syFrameStatsDestroy(&s);
+  return (TestStatus){.result = TEST_SUCCESS};
+}
+
+TEST(framestats_hitches) {
+  syFrameStats s;
+  syFrameStatsInit(&s);
+  for (int i = 0; i < SY_FRAME_STATS_CAPACITY; i++) {
+    double t = i % 64 == 63 ? 0.05 : 0.016;
+    syFrameStatsPush(&s, (syFrameTimes){.total = t}, 0);
+  }
+  EXPECT(s.numHitches == SY_FRAME_STATS_CAPACITY / 64);
+  EXPECT(s.recentHitches == s.numHitches);
+  // Hitches leave the window as newer frames replace them
+  for (int i = 0; i < SY_FRAME_STATS_CAPACITY; i++) {
+    syFrameStatsPush(&s, (syFrameTimes){.total = 0.016}, 0);
+  }
+  EXPECT(s.recentHitches == 0);
+  EXPECT(s.numHitches == SY_FRAME_STATS_CAPACITY / 64);
+  syFrameStatsDestroy(&s);
+  return (TestStatus){.result = TEST_SUCCESS};
+}
+
+TEST(framestats_median) {
+  syFrameStats s;
+  syFrameStatsInit(&s);
+  // Selecting the median matches sorting for any number of frames, with
+  // repeated times
+  for (int i = 0; i < SY_FRAME_STATS_CAPACITY + 10; i++) {
+    double t = (double)((i * 37) % 23) / 1000;
+    syFrameStatsPush(&s, (syFrameTimes){.total = t}, 0);
+    double median = syFrameStatsMedian(&s);
+    syFrameStatsUpdate(&s);
+    EXPECT(median == s.total.p50);
+  }
+  syFrameStatsDestroy(&s);
+  return (TestStatus){.result = TEST_SUCCESS};
+}
@@ -3,6 +3,8 @@
 #include "common.h"
 #include "test_color.h"
 #include "test_vec.h"
+#include "test_framestats.h"
+#include "test_commands.h"
 
 // clang-format off
 
@@ -11,7 +13,18 @@ TESTS {
   REGISTER(color_syRgb)
   REGISTER(color_conversions)
   REGISTER(color_with_alpha)
+  REGISTER(color_pack)
+  REGISTER(color_pack_array)
   REGISTER(vec_push3)
+  REGISTER(framestats_percentiles)
+  REGISTER(framestats_hitches)
+  REGISTER(framestats_median)
+  REGISTER(commands_sort_stable)
+  REGISTER(commands_sort_ordered)
+  REGISTER(commands_sort_passes)
+  REGISTER(commands_barrier_limit)
+  REGISTER(commands_sort_pools)
+  REGISTER(commands_reserve_pass)
 
 };
 